@@ -0,0 +1,199 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <fstream>
+#include <filesystem>
+
+#include "string_helper.h"
+#include "log_record.h"
+#include "mapped_log_file.h"
+#include "csv_scanner.h"
+#include "id_helper.h"
+#include "sort_key.h"
+#include "radix_sort.h"
+
+using namespace std;
+
+/**
+ * Micro benchmarks for the hot paths shared by the loyal customers tools and the external sorter.
+ *
+ * Every benchmark runs over the same in memory log lines, so the numbers only compare CPU work and not I/O.
+ */
+
+/**
+ * Run a benchmark and print its time
+ * @param name benchmark name
+ * @param records records processed by one run of body
+ * @param body benchmark body, returns a checksum so the work cannot be optimized away
+ */
+void run_benchmark(const string &name, const size_t records, const function<size_t()> &body) {
+    const auto start = chrono::steady_clock::now();
+    const size_t checksum = body();
+    const auto end = chrono::steady_clock::now();
+    const double milliseconds = chrono::duration<double, milli>(end - start).count();
+    cout << name << ": " << milliseconds << " milliseconds, " << records / milliseconds * 1000 << " records/s"
+         << " (checksum " << checksum << ")" << endl;
+}
+
+/**
+ * Generate log lines in cvs format: timestamp, page_id, customer_id
+ * @param lines_count number of lines
+ * @return generated log lines
+ */
+vector<string> generate_log_lines(const size_t lines_count) {
+    vector<string> page_ids(2000), customer_ids(500);
+    for (auto &page_id: page_ids) page_id = string_helper::generate_random_string(16);
+    for (auto &customer_id: customer_ids) customer_id = string_helper::generate_uuid_v4();
+
+    mt19937_64 generator(42);
+    vector<string> lines;
+    lines.reserve(lines_count);
+    for (size_t i = 0; i < lines_count; i++)
+        lines.push_back(to_string(1700000000000 + generator() % 86400000) + "," +
+                        page_ids[generator() % page_ids.size()] + "," +
+                        customer_ids[generator() % customer_ids.size()]);
+    return lines;
+}
+
+void benchmark_split(const vector<string> &lines) {
+    run_benchmark("string_helper::split", lines.size(), [&lines]() {
+        size_t checksum = 0;
+        for (const auto &line: lines) {
+            const vector<string> data = string_helper::split(line, ",");
+            checksum += data[1].size() + data[2].size();
+        }
+        return checksum;
+    });
+
+    run_benchmark("log_record::parse", lines.size(), [&lines]() {
+        size_t checksum = 0;
+        log_record record;
+        for (const auto &line: lines) {
+            log_record::parse(line, record);
+            checksum += record.page_id.size() + record.customer_id.size();
+        }
+        return checksum;
+    });
+}
+
+void benchmark_parse_uuid(const vector<string> &lines) {
+    vector<string_view> customer_ids(lines.size());
+    log_record record;
+    for (size_t i = 0; i < lines.size(); i++) {
+        log_record::parse(lines[i], record);
+        customer_ids[i] = record.customer_id;
+    }
+
+    run_benchmark("id_helper::parse_uuid", customer_ids.size(), [&customer_ids]() {
+        size_t checksum = 0;
+        uuid128 customer_id;
+        for (const auto &each_customer_id: customer_ids)
+            if (id_helper::parse_uuid(each_customer_id, customer_id)) checksum += customer_id.low & 0xFF;
+        return checksum;
+    });
+}
+
+void benchmark_read(const vector<string> &lines) {
+    const string file_name = "benchmark.log";
+    ofstream file_writer(file_name);
+    for (const auto &line: lines) file_writer << line << '\n';
+    file_writer.close();
+
+    run_benchmark("ifstream getline + log_record::parse", lines.size(), [&file_name]() {
+        size_t checksum = 0;
+        ifstream file_reader(file_name);
+        string line;
+        log_record record;
+        while (getline(file_reader, line)) {
+            log_record::parse(line, record);
+            checksum += record.page_id.size() + record.customer_id.size();
+        }
+        return checksum;
+    });
+
+    run_benchmark(string("MappedLogFile (") + csv_scanner::implementation() + " scan)", lines.size(), [&file_name]() {
+        size_t checksum = 0;
+        const MappedLogFile file_reader(file_name);
+        for (const auto &record: file_reader)
+            checksum += record.page_id.size() + record.customer_id.size();
+        return checksum;
+    });
+
+    filesystem::remove(file_name);
+}
+
+void benchmark_sort(const vector<string> &lines) {
+    // Sort by CustomerId, PageId like the loyal customers tools and the external sorter
+    const vector<int> sort_array = {2, 1};
+    const sort_key_encoder sort_key(sort_array);
+
+    // Every sort produces the sorted order of row indexes, so only the sorting itself is measured
+    for (size_t size = 256; size <= lines.size(); size *= 4) {
+        // Repeat small sizes so every measure sorts about the same number of rows
+        const size_t repeats = max<size_t>(1, lines.size() / size);
+        vector<vector<string>> rows(size);
+        vector<string> keys(size);
+        for (size_t i = 0; i < size; i++) {
+            rows[i] = string_helper::split(lines[i], ",");
+            sort_key.encode(lines[i], keys[i]);
+        }
+        vector<uint32_t> order(size);
+        cout << "Sorting " << size << " rows " << repeats << " times" << endl;
+
+        run_benchmark("  std::sort with column comparator", size * repeats, [&]() {
+            size_t checksum = 0;
+            for (size_t repeat = 0; repeat < repeats; repeat++) {
+                for (size_t i = 0; i < size; i++) order[i] = static_cast<uint32_t>(i);
+                sort(order.begin(), order.end(), [&rows, &sort_array](const uint32_t row1, const uint32_t row2) {
+                    for (auto &sort_column: sort_array)
+                        if (rows[row1][sort_column] != rows[row2][sort_column])
+                            return rows[row1][sort_column] < rows[row2][sort_column];
+                    return false;
+                });
+                checksum += rows[order[0]][2].size();
+            }
+            return checksum;
+        });
+
+        run_benchmark("  std::sort on normalized keys", size * repeats, [&]() {
+            size_t checksum = 0;
+            for (size_t repeat = 0; repeat < repeats; repeat++) {
+                for (size_t i = 0; i < size; i++) order[i] = static_cast<uint32_t>(i);
+                sort(order.begin(), order.end(), [&keys](const uint32_t row1, const uint32_t row2) {
+                    return keys[row1] < keys[row2];
+                });
+                checksum += keys[order[0]].size();
+            }
+            return checksum;
+        });
+
+        run_benchmark("  MSD radix sort on normalized keys", size * repeats, [&]() {
+            size_t checksum = 0;
+            for (size_t repeat = 0; repeat < repeats; repeat++) {
+                order = radix_sort_order(size, [&keys](const uint32_t row) { return string_view(keys[row]); });
+                checksum += keys[order[0]].size();
+            }
+            return checksum;
+        });
+    }
+}
+
+int main(const int argc, const char *argv[]) {
+    const size_t lines_count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1000000;
+
+    cout << "Generating " << lines_count << " log lines" << endl;
+    const vector<string> lines = generate_log_lines(lines_count);
+
+    benchmark_split(lines);
+    benchmark_parse_uuid(lines);
+    benchmark_read(lines);
+    benchmark_sort(lines);
+
+    return 0;
+}
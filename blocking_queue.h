@@ -0,0 +1,75 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_BLOCKING_QUEUE_H
+#define TEST_BLOCKING_QUEUE_H
+
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+ * Bounded multi producer, multi consumer queue used to hand work between pipeline threads.
+ *
+ * push blocks while the queue is full and pop blocks while it is empty. Once closed, push is refused and pop drains
+ * what is left before reporting the end.
+ */
+template<typename T>
+class blocking_queue {
+public:
+    explicit blocking_queue(const size_t capacity = numeric_limits<size_t>::max()) : capacity(capacity) {}
+
+    /**
+     * Add an item, waiting for room if the queue is full
+     * @param item item to add
+     * @return false if the queue is closed
+     */
+    bool push(T item) {
+        unique_lock<mutex> lock(items_mutex);
+        not_full.wait(lock, [this]() { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * Take the oldest item, waiting for one if the queue is empty
+     * @param item output item
+     * @return false if the queue is closed and empty
+     */
+    bool pop(T &item) {
+        unique_lock<mutex> lock(items_mutex);
+        not_empty.wait(lock, [this]() { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * Refuse new items and wake up every waiting thread
+     */
+    void close() {
+        lock_guard<mutex> lock(items_mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+private:
+    const size_t capacity;
+    deque<T> items;
+    bool closed = false;
+    mutex items_mutex;
+    condition_variable not_empty;
+    condition_variable not_full;
+};
+
+#endif //TEST_BLOCKING_QUEUE_H
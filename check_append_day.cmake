@@ -0,0 +1,28 @@
+# Fold the day logs one at a time with --append-day, with a missing day log in between that must fail and leave the
+# checkpoint as it was, then compare the loyal customers of the last day with the expected ones
+# -DENGINE=<GetLoyalCustomersUsingHash binary> -DEXPECTED=<result file>, run from a directory whose ../logs has the
+# day logs
+include(${CMAKE_CURRENT_LIST_DIR}/loyal_customers.cmake)
+
+set(checkpoint loyalty.checkpoint)
+file(REMOVE ${checkpoint})
+foreach (day_log day1.log day2.log missing.log day3.log)
+    if (EXISTS ${checkpoint})
+        file(SHA256 ${checkpoint} checkpoint_before)
+    endif ()
+    execute_process(COMMAND ${ENGINE} --append-day ../logs/${day_log} ${checkpoint}
+            RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+    if (day_log STREQUAL "missing.log")
+        file(SHA256 ${checkpoint} checkpoint_after)
+        if (result EQUAL 0 OR NOT checkpoint_before STREQUAL checkpoint_after)
+            message(FATAL_ERROR "Appending a missing day log must fail and keep the checkpoint:\n${output}${error}")
+        endif ()
+    elseif (NOT result EQUAL 0)
+        message(FATAL_ERROR "Appending ${day_log} failed with ${result}:\n${output}${error}")
+    endif ()
+endforeach ()
+
+if (NOT output MATCHES "Day 3 has been appended")
+    message(FATAL_ERROR "The missing day log must not count as a day:\n${output}")
+endif ()
+compare_loyal_customers("${ENGINE} --append-day" "${output}" ${EXPECTED})
@@ -0,0 +1,11 @@
+# Run a loyalty engine and compare the loyal customers it prints with the expected ones, in any order
+# -DENGINE=<engine binary> -DEXPECTED=<result file> [-DARGS=<space separated arguments>], run from a directory whose
+# ../logs has the day logs
+include(${CMAKE_CURRENT_LIST_DIR}/loyal_customers.cmake)
+
+separate_arguments(args UNIX_COMMAND "${ARGS}")
+execute_process(COMMAND ${ENGINE} ${args} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${ENGINE} ${ARGS} failed with ${result}:\n${output}${error}")
+endif ()
+compare_loyal_customers("${ENGINE} ${ARGS}" "${output}" ${EXPECTED})
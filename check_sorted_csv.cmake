@@ -0,0 +1,31 @@
+# Generate a cvs log, sort it with ExternalSortingCSV by CustomerId then PageId, and compare with
+# LC_ALL=C sort -t, -k3,3 -k2,2 -s: the keys must come in the same order and the rows must be the same. Rows with equal
+# keys may come in any order, run generation does not keep their input order
+# -DSORTER=<ExternalSortingCSV binary> -DMEM_SIZE=<memory budget> -DSTRATEGY=<0, sort threads or replacement>
+execute_process(COMMAND ${SORTER} input.csv 200000 --seed 7 RESULT_VARIABLE result OUTPUT_VARIABLE output)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "Generating input.csv failed with ${result}:\n${output}")
+endif ()
+execute_process(COMMAND ${SORTER} input.csv output.csv ${MEM_SIZE} ${STRATEGY}
+        RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+if (NOT result EQUAL 0 OR NOT output MATCHES "Writing run_2.csv")
+    message(FATAL_ERROR "Sorting input.csv into several runs failed with ${result}:\n${output}${error}")
+endif ()
+execute_process(COMMAND ${CMAKE_COMMAND} -E env LC_ALL=C sort -t, -k3,3 -k2,2 -s input.csv
+        RESULT_VARIABLE result OUTPUT_FILE expected.csv)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "sort failed with ${result}")
+endif ()
+
+file(STRINGS output.csv actual_rows)
+file(STRINGS expected.csv expected_rows)
+list(TRANSFORM actual_rows REPLACE "^[^,]*,([^,]*),(.*)$" "\\2,\\1" OUTPUT_VARIABLE actual_keys)
+list(TRANSFORM expected_rows REPLACE "^[^,]*,([^,]*),(.*)$" "\\2,\\1" OUTPUT_VARIABLE expected_keys)
+if (NOT actual_keys STREQUAL expected_keys)
+    message(FATAL_ERROR "output.csv is not sorted by CustomerId then PageId")
+endif ()
+list(SORT actual_rows)
+list(SORT expected_rows)
+if (NOT actual_rows STREQUAL expected_rows)
+    message(FATAL_ERROR "output.csv does not have the rows of input.csv")
+endif ()
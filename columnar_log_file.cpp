@@ -0,0 +1,251 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "columnar_log_file.h"
+
+static const char COLUMNAR_MAGIC[8] = {'L', 'C', 'O', 'L', 'U', 'M', 'N', '1'};
+
+/**
+ * Fixed size header at the start of a columnar file, padded so the first block starts on a 16 bytes boundary
+ */
+struct columnar_header {
+    char magic[8];
+    uint64_t records_count;
+    uint64_t blocks_count;
+    uint64_t dictionary_offset;
+    uint64_t block_index_offset;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(columnar_header) % 16 == 0, "blocks must start on a 16 bytes boundary");
+
+/**
+ * Block index entry at the end of a columnar file
+ */
+struct columnar_block_entry {
+    uint64_t offset;
+    uint64_t records_count;
+    uuid128 min_customer_id;
+    uuid128 max_customer_id;
+};
+
+/**
+ * Write the columns of one block, every column starting on a 16 bytes boundary
+ * @param output columnar file
+ * @param timestamps timestamp column
+ * @param page_ids page ordinal column
+ * @param customer_ids customer id column
+ * @param block_index block index to add the block to
+ */
+static void write_block(ofstream &output, const vector<int64_t> &timestamps, const vector<page_ordinal> &page_ids,
+                        const vector<uuid128> &customer_ids, vector<columnar_block_entry> &block_index) {
+    static const char PADDING[16] = {};
+    columnar_block_entry entry{static_cast<uint64_t>(output.tellp()), timestamps.size(), customer_ids[0],
+                               customer_ids[0]};
+    for (const auto &customer_id: customer_ids) {
+        if (customer_id < entry.min_customer_id) entry.min_customer_id = customer_id;
+        if (entry.max_customer_id < customer_id) entry.max_customer_id = customer_id;
+    }
+    block_index.push_back(entry);
+
+    const auto write_column = [&output](const void *data, const size_t size) {
+        output.write(static_cast<const char *>(data), static_cast<streamsize>(size));
+        output.write(PADDING, static_cast<streamsize>((16 - size % 16) % 16));
+    };
+    write_column(timestamps.data(), timestamps.size() * sizeof(int64_t));
+    write_column(page_ids.data(), page_ids.size() * sizeof(page_ordinal));
+    write_column(customer_ids.data(), customer_ids.size() * sizeof(uuid128));
+}
+
+/**
+ * Get the size of a column padded to 16 bytes
+ * @param size column size in bytes
+ * @return padded column size in bytes
+ */
+static size_t padded(const size_t size) {
+    return (size + 15) / 16 * 16;
+}
+
+/**
+ * Check that a range of bytes is inside a file, with no overflow
+ * @param offset start of the range
+ * @param size size of the range in bytes
+ * @param file_size file size in bytes
+ * @return true if the range is inside the file
+ */
+static bool in_file(const uint64_t offset, const uint64_t size, const uint64_t file_size) {
+    return offset <= file_size && size <= file_size - offset;
+}
+
+/**
+ * Print a warning for the records of a log file skipped because of a malformed timestamp
+ * @param file_name log file name
+ * @param malformed_count number of records skipped, nothing is printed when 0
+ */
+static void report_malformed_timestamps(const string &file_name, const size_t malformed_count) {
+    if (malformed_count > 0)
+        cerr << "Skipped " << malformed_count << " records of " << file_name << " with a malformed timestamp" << endl;
+}
+
+long ColumnarLogFile::convert(const string &cvs_file_name, const string &columnar_file_name,
+                              size_t block_records) {
+    if (block_records == 0) block_records = DEFAULT_BLOCK_RECORDS;
+    const MappedLogFile cvs_file(cvs_file_name);
+    if (!cvs_file.is_open()) return -1;
+    ofstream output(columnar_file_name, ios::binary | ios::trunc);
+    if (!output.is_open()) return -1;
+
+    // Header is rewritten once the offsets are known
+    columnar_header header{};
+    memcpy(header.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    page_dictionary pages;
+    vector<columnar_block_entry> block_index;
+    vector<int64_t> timestamps;
+    vector<page_ordinal> page_ids;
+    vector<uuid128> customer_ids;
+    timestamps.reserve(block_records);
+    page_ids.reserve(block_records);
+    customer_ids.reserve(block_records);
+
+    long records_count = 0;
+    size_t malformed_count = 0, malformed_timestamps_count = 0;
+    for (const auto &record: cvs_file) {
+        int64_t timestamp;
+        uuid128 customer_id;
+        const char *timestamp_end = record.timestamp.data() + record.timestamp.size();
+        const auto result = from_chars(record.timestamp.data(), timestamp_end, timestamp);
+        // The whole field must be the number, "123abc" is malformed too
+        if (result.ec != errc() || result.ptr != timestamp_end) {
+            malformed_timestamps_count++;
+            continue;
+        }
+        if (!id_helper::parse_uuid(record.customer_id, customer_id)) {
+            malformed_count++;
+            continue;
+        }
+        timestamps.push_back(timestamp);
+        page_ids.push_back(pages.intern(record.page_id));
+        customer_ids.push_back(customer_id);
+        records_count++;
+        if (timestamps.size() == block_records) {
+            write_block(output, timestamps, page_ids, customer_ids, block_index);
+            timestamps.clear();
+            page_ids.clear();
+            customer_ids.clear();
+        }
+    }
+    if (!timestamps.empty())
+        write_block(output, timestamps, page_ids, customer_ids, block_index);
+    report_malformed_timestamps(cvs_file_name, malformed_timestamps_count);
+    id_helper::report_malformed_ids(cvs_file_name, malformed_count);
+
+    header.records_count = records_count;
+    header.blocks_count = block_index.size();
+    header.dictionary_offset = output.tellp();
+    const auto pages_count = static_cast<uint32_t>(pages.size());
+    output.write(reinterpret_cast<const char *>(&pages_count), sizeof(pages_count));
+    pages.write(output);
+    // Keep the block index aligned for direct reads
+    while (output.tellp() % 16 != 0) output.put('\0');
+    header.block_index_offset = output.tellp();
+    output.write(reinterpret_cast<const char *>(block_index.data()),
+                 static_cast<streamsize>(block_index.size() * sizeof(columnar_block_entry)));
+
+    output.seekp(0);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.close();
+    // A partly written file is rejected by open as damaged
+    if (output.fail()) return -1;
+    return records_count;
+}
+
+bool ColumnarLogFile::is_columnar(const string &file_name) {
+    ifstream input(file_name, ios::binary);
+    char magic[sizeof(COLUMNAR_MAGIC)] = {};
+    input.read(magic, sizeof(magic));
+    return input.gcount() == sizeof(magic) && memcmp(magic, COLUMNAR_MAGIC, sizeof(magic)) == 0;
+}
+
+bool ColumnarLogFile::open(const string &file_name) {
+    close();
+    if (!file.open(file_name) || file.size() < sizeof(columnar_header)) return false;
+    const char *data = file.data().data();
+    const uint64_t file_size = file.size();
+    columnar_header header{};
+    memcpy(&header, data, sizeof(header));
+    // Every offset and size read from the file is checked against its size before use, a damaged file is rejected
+    if (memcmp(header.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) != 0 || header.block_index_offset % 16 != 0 ||
+        header.blocks_count > file_size / sizeof(columnar_block_entry) ||
+        !in_file(header.block_index_offset, header.blocks_count * sizeof(columnar_block_entry), file_size) ||
+        !in_file(header.dictionary_offset, sizeof(uint32_t), file_size)) {
+        close();
+        return false;
+    }
+
+    uint32_t pages_count;
+    memcpy(&pages_count, data + header.dictionary_offset, sizeof(pages_count));
+    string_view dictionary = file.data().substr(header.dictionary_offset + sizeof(pages_count));
+    if (!pages.read(dictionary, pages_count)) {
+        close();
+        return false;
+    }
+
+    const auto *block_index = reinterpret_cast<const columnar_block_entry *>(data + header.block_index_offset);
+    blocks.reserve(header.blocks_count);
+    uint64_t blocks_records_count = 0;
+    for (uint64_t i = 0; i < header.blocks_count; i++) {
+        const columnar_block_entry &entry = block_index[i];
+        const uint64_t n = entry.records_count;
+        // Columns are read in place, they must be aligned and inside the file
+        if (entry.offset % 16 != 0 || n > file_size / (sizeof(int64_t) + sizeof(page_ordinal) + sizeof(uuid128)) ||
+            !in_file(entry.offset, padded(n * sizeof(int64_t)) + padded(n * sizeof(page_ordinal)) +
+                                   n * sizeof(uuid128), file_size)) {
+            close();
+            return false;
+        }
+        const char *columns = data + entry.offset;
+        block each_block{n, reinterpret_cast<const int64_t *>(columns),
+                         reinterpret_cast<const page_ordinal *>(columns + padded(n * sizeof(int64_t))),
+                         reinterpret_cast<const uuid128 *>(columns + padded(n * sizeof(int64_t)) +
+                                                           padded(n * sizeof(page_ordinal))),
+                         entry.min_customer_id, entry.max_customer_id};
+        for (size_t record = 0; record < n; record++)
+            if (each_block.page_ids[record] >= pages.size()) {
+                close();
+                return false;
+            }
+        blocks.push_back(each_block);
+        blocks_records_count += n;
+    }
+    if (blocks_records_count != header.records_count) {
+        close();
+        return false;
+    }
+    records = header.records_count;
+    return true;
+}
+
+void ColumnarLogFile::format_row(const block &each_block, const size_t index, string &row) const {
+    char timestamp[24];
+    const auto result = to_chars(timestamp, timestamp + sizeof(timestamp), each_block.timestamps[index]);
+    row.assign(timestamp, result.ptr - timestamp);
+    row.push_back(',');
+    row.append(pages.page_id(each_block.page_ids[index]));
+    row.push_back(',');
+    row.append(id_helper::to_uuid_string(each_block.customer_ids[index]));
+}
+
+void ColumnarLogFile::close() {
+    file.close();
+    records = 0;
+    blocks.clear();
+    pages = page_dictionary();
+}
@@ -0,0 +1,95 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_COLUMNAR_LOG_FILE_H
+#define TEST_COLUMNAR_LOG_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "id_helper.h"
+#include "mapped_log_file.h"
+
+using namespace std;
+
+/**
+ * Binary columnar day log: a day log converted once from cvs, then read many times at memory speed with no parsing.
+ *
+ * Records are stored in blocks of up to block_records records. Each block holds three columns one after the other:
+ * int64 timestamps, uint32 page ordinals and uuid128 customer ids. The page ordinals index the file's page dictionary.
+ * A block index at the end of the file keeps every block's offset, size and min/max customer id, so readers can skip
+ * blocks that cannot hold the customers they look for. Numbers are stored in host byte order.
+ *
+ * Layout: header | blocks | page dictionary (uint32 count, then uint16 length + bytes per page) | block index
+ */
+class ColumnarLogFile {
+public:
+    static const size_t DEFAULT_BLOCK_RECORDS = 64 * 1024;
+
+    /**
+     * One block of records, every pointer points into the mapped file
+     */
+    struct block {
+        size_t records_count;
+        const int64_t *timestamps;
+        const page_ordinal *page_ids;
+        const uuid128 *customer_ids;
+        uuid128 min_customer_id;
+        uuid128 max_customer_id;
+    };
+
+    /**
+     * Convert a cvs day log into the columnar format. Records with a malformed timestamp or customer id are skipped
+     * @param cvs_file_name day log file in cvs format
+     * @param columnar_file_name output columnar file
+     * @param block_records max number of records per block
+     * @return number of records written, or -1 if a file cannot be opened or written
+     */
+    static long convert(const string &cvs_file_name, const string &columnar_file_name,
+                        size_t block_records = DEFAULT_BLOCK_RECORDS);
+
+    /**
+     * Check if a file is in the columnar format
+     * @param file_name file name
+     * @return true if the file starts with the columnar magic
+     */
+    static bool is_columnar(const string &file_name);
+
+    /**
+     * Map a columnar file and load its page dictionary and block index
+     * @param file_name columnar file name
+     * @return false if the file cannot be read, is not in the columnar format or is damaged
+     */
+    bool open(const string &file_name);
+
+    void close();
+
+    size_t records_count() const { return records; }
+
+    size_t blocks_count() const { return blocks.size(); }
+
+    const block &get_block(const size_t index) const { return blocks[index]; }
+
+    /**
+     * Format one record back into a cvs row: Timestamp, PageId, CustomerId
+     * @param each_block block of the record
+     * @param index index of the record in the block
+     * @param row output cvs row, reused between records to avoid allocations
+     */
+    void format_row(const block &each_block, size_t index, string &row) const;
+
+    /**
+     * Page dictionary of the file, page ordinals of the blocks index it
+     */
+    const page_dictionary &page_ids() const { return pages; }
+
+private:
+    MappedLogFile file;
+    size_t records = 0;
+    vector<block> blocks;
+    page_dictionary pages;
+};
+
+#endif //TEST_COLUMNAR_LOG_FILE_H
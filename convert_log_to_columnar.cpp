@@ -0,0 +1,39 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <iostream>
+#include <string>
+
+#include "columnar_log_file.h"
+#include "metrics.h"
+
+using namespace std;
+
+/**
+ * Convert a day log in cvs format (Timestamp, PageId, CustomerId) into the binary columnar format read by
+ * GetLoyalCustomersUsingHash and ExternalSortingCSV. Meant to run once per day, when the log is rotated.
+ */
+int main(const int argc, const char *argv[]) {
+    metrics::start("ConvertLogToColumnar");
+    if (argc == 3 || argc == 4) {
+        const string input_name = argv[1];
+        const string output_name = argv[2];
+        const size_t block_records = argc == 4 ? strtoul(argv[3], nullptr, 0)
+                                               : ColumnarLogFile::DEFAULT_BLOCK_RECORDS;
+
+        const metrics::scoped_timer timer("convert");
+        const long records_count = ColumnarLogFile::convert(input_name, output_name, block_records);
+        if (records_count < 0) {
+            cout << "File '" << input_name << "' or '" << output_name << "' cannot be opened or written!" << endl
+                 << "Exit program!" << endl;
+            return -1;
+        }
+        cout << "File " << output_name << " has been generated with " << records_count << " records" << endl;
+        return 0;
+    }
+
+    cout << "To convert a cvs log file: input_file output_file [block_records]" << endl <<
+         "Exit program!" << endl;
+    return -1;
+}
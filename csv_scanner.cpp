@@ -0,0 +1,119 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include "csv_scanner.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CSV_SCANNER_X86
+
+#include <immintrin.h>
+
+#endif
+
+using scan_function = size_t (*)(const char *, size_t, char, uint32_t *);
+
+/**
+ * Scan a buffer byte by byte from start, also used for the tail shorter than a vector
+ * @param start offset of the first byte to scan
+ * @param count number of offsets written so far
+ * @return number of offsets written
+ */
+static size_t scan_from(const char *data, const size_t size, const char delimiter, uint32_t *positions,
+                        const size_t start, size_t count) {
+    for (size_t i = start; i < size; i++)
+        if (data[i] == '\n' || data[i] == delimiter) positions[count++] = static_cast<uint32_t>(i);
+    return count;
+}
+
+#ifndef CSV_SCANNER_X86
+
+static size_t scan_scalar(const char *data, const size_t size, const char delimiter, uint32_t *positions) {
+    return scan_from(data, size, delimiter, positions, 0, 0);
+}
+
+#endif
+
+#ifdef CSV_SCANNER_X86
+
+/**
+ * Append the offsets of the set bits of a match mask
+ * @param mask one bit per byte of a block, set on new lines and delimiters
+ * @param offset offset of the block in the buffer
+ * @param positions output offsets
+ * @param count number of offsets written so far, updated
+ */
+static inline void append_matches(uint32_t mask, const size_t offset, uint32_t *positions, size_t &count) {
+    while (mask != 0) {
+        positions[count++] = static_cast<uint32_t>(offset + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+}
+
+// SSE2 is part of x86-64, so this one needs no runtime check
+static size_t scan_sse2(const char *data, const size_t size, const char delimiter, uint32_t *positions) {
+    const __m128i new_lines = _mm_set1_epi8('\n'), delimiters = _mm_set1_epi8(delimiter);
+    size_t count = 0, i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(block, new_lines), _mm_cmpeq_epi8(block, delimiters));
+        append_matches(static_cast<uint32_t>(_mm_movemask_epi8(matches)), i, positions, count);
+    }
+    return scan_from(data, size, delimiter, positions, i, count);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *data, const size_t size, const char delimiter, uint32_t *positions) {
+    const __m256i new_lines = _mm256_set1_epi8('\n'), delimiters = _mm256_set1_epi8(delimiter);
+    size_t count = 0, i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(block, new_lines),
+                                                _mm256_cmpeq_epi8(block, delimiters));
+        append_matches(static_cast<uint32_t>(_mm256_movemask_epi8(matches)), i, positions, count);
+    }
+    return scan_from(data, size, delimiter, positions, i, count);
+}
+
+#endif
+
+/**
+ * Pick the fastest implementation the CPU supports
+ * @param name output name of the implementation
+ * @return scan function
+ */
+static scan_function select_scan(const char **name) {
+#ifdef CSV_SCANNER_X86
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return scan_avx2;
+    }
+    *name = "sse2";
+    return scan_sse2;
+#else
+    *name = "scalar";
+    return scan_scalar;
+#endif
+}
+
+/**
+ * Get the implementation picked for this CPU, on first use so scanning works from any static initializer too
+ * @param name output name of the implementation, may be nullptr
+ * @return scan function
+ */
+static scan_function selected_scan(const char **name = nullptr) {
+    static const char *selected_name = nullptr;
+    static const scan_function selected = select_scan(&selected_name);
+    if (name) *name = selected_name;
+    return selected;
+}
+
+size_t csv_scanner::scan(const char *data, const size_t size, const char delimiter, uint32_t *positions) {
+    return selected_scan()(data, size, delimiter, positions);
+}
+
+const char *csv_scanner::implementation() {
+    const char *name;
+    selected_scan(&name);
+    return name;
+}
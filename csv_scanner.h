@@ -0,0 +1,38 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_CSV_SCANNER_H
+#define TEST_CSV_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * Finds every new line and delimiter of a cvs buffer in one pass, 32 or 16 bytes at a time with AVX2 or SSE2.
+ *
+ * The implementation is picked once at startup from what the CPU supports, with a scalar fallback on other CPUs. The
+ * positions found are the record and field index of the buffer: readers walk them instead of searching every line and
+ * every field again.
+ */
+class csv_scanner {
+public:
+    /**
+     * Find the new lines and delimiters of a buffer
+     * @param data buffer to scan
+     * @param size size of data, less than 4GB
+     * @param delimiter field delimiter
+     * @param positions output offsets in data of every new line and delimiter in increasing order, room for size
+     * @return number of positions written
+     */
+    static size_t scan(const char *data, size_t size, char delimiter, uint32_t *positions);
+
+    /**
+     * Name of the implementation in use: "avx2", "sse2" or "scalar"
+     */
+    static const char *implementation();
+};
+
+#endif //TEST_CSV_SCANNER_H
@@ -0,0 +1,42 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include "customer_filter.h"
+
+// Odd multipliers picking the bit of each word of a block from the low 32 hash bits
+static const uint32_t WORD_SALTS[] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                      0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+customer_filter::customer_filter(const size_t customers_count, const size_t bits_per_customer)
+        : blocks(max<size_t>(1, (customers_count * bits_per_customer + 511) / 512)) {}
+
+uint64_t customer_filter::hash(const uuid128 &customer_id) {
+    // Independent of uuid128_hash, so the filter does not correlate with the probe order of the hash tables
+    uint64_t h = customer_id.high * 0xC2B2AE3D27D4EB4FULL ^ customer_id.low * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 32);
+}
+
+void customer_filter::insert(const uuid128 &customer_id) {
+    const uint64_t h = hash(customer_id);
+    auto &words = blocks[block_index(h)].words;
+    for (size_t i = 0; i < BLOCK_WORDS; i++)
+        words[i] |= uint64_t(1) << (static_cast<uint32_t>(h) * WORD_SALTS[i] >> 26);
+}
+
+bool customer_filter::may_contain(const uuid128 &customer_id) const {
+    const uint64_t h = hash(customer_id);
+    const auto &words = blocks[block_index(h)].words;
+    for (size_t i = 0; i < BLOCK_WORDS; i++)
+        if ((words[i] & uint64_t(1) << (static_cast<uint32_t>(h) * WORD_SALTS[i] >> 26)) == 0) return false;
+    return true;
+}
+
+bool customer_filter::may_come_on_another_day(const vector<customer_filter> &customers_by_day,
+                                              const uuid128 &customer_id, const int day) {
+    if (customers_by_day.empty()) return true;
+    for (size_t each_day = 1; each_day <= customers_by_day.size(); each_day++)
+        if (each_day != size_t(day) && customers_by_day[each_day - 1].may_contain(customer_id)) return true;
+    return false;
+}
@@ -0,0 +1,63 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_CUSTOMER_FILTER_H
+#define TEST_CUSTOMER_FILTER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "id_helper.h"
+
+using namespace std;
+
+/**
+ * Blocked Bloom filter of customer ids: tells for sure that a customer never came on a day, with a small false
+ * positive rate the other way.
+ *
+ * Every customer sets one bit in each of the 8 words of a single 64-byte block, so inserting or probing touches one
+ * cache line. With the default 10 bits per customer about 1% of the absent customers are reported as maybe present.
+ */
+class customer_filter {
+public:
+    /**
+     * @param customers_count expected number of customers, an upper bound is fine
+     * @param bits_per_customer filter bits per expected customer, more bits for fewer false positives
+     */
+    explicit customer_filter(size_t customers_count, size_t bits_per_customer = 10);
+
+    void insert(const uuid128 &customer_id);
+
+    /**
+     * Check whether a customer may have been inserted
+     * @param customer_id customer id
+     * @return false if the customer has surely not been inserted
+     */
+    bool may_contain(const uuid128 &customer_id) const;
+
+    /**
+     * Check whether a customer may have come on another day than day
+     * @param customers_by_day filters of the customers of every day, empty when not prefiltering
+     * @param customer_id customer id
+     * @param day day being processed, from 1
+     * @return false if the customer surely came on no other day, true when not prefiltering
+     */
+    static bool may_come_on_another_day(const vector<customer_filter> &customers_by_day, const uuid128 &customer_id,
+                                        int day);
+
+private:
+    static const size_t BLOCK_WORDS = 8;
+
+    struct block {
+        uint64_t words[BLOCK_WORDS];
+    };
+
+    static uint64_t hash(const uuid128 &customer_id);
+
+    size_t block_index(uint64_t h) const { return (h >> 32) * blocks.size() >> 32; }
+
+    vector<block> blocks;
+};
+
+#endif //TEST_CUSTOMER_FILTER_H
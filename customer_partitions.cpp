@@ -0,0 +1,208 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+#include "customer_partitions.h"
+#include "customer_state_table.h"
+#include "log_record.h"
+#include "mapped_log_file.h"
+#include "metrics.h"
+
+// Memory of one customer in a customer_state_table, which is at most half full
+static const uint64_t TABLE_BYTES_PER_CUSTOMER = 2 * sizeof(customer_state);
+// Write buffer of every partition file, two of them per partition
+static const size_t PARTITION_WRITE_BUFFER_SIZE = 64 * 1024;
+// Memory of every partition open while scattering
+static const uint64_t SCATTER_BYTES_PER_PARTITION = 2 * PARTITION_WRITE_BUFFER_SIZE;
+// Read ahead block of a partition file, a whole number of records
+static const size_t PARTITION_READ_RECORDS = 32 * 1024;
+// Smallest read ahead block of a partition file, for a small memory budget
+static const size_t MIN_PARTITION_READ_RECORDS = 256;
+// All the partition files are open at once, stay below the usual limit of 1024 open files
+static const size_t MAX_PARTITIONS = 1000;
+// Times the records of a partition are partitioned at most, the visits of a single customer cannot be split anyway
+static const size_t MAX_PARTITION_LEVELS = 3;
+// Partitions of every level take the next digits of the high 32 bits of the hash, the tables probe with the low ones
+static const uint64_t PARTITION_HASH_VALUES = uint64_t(1) << 32;
+
+customer_partitions::customer_partitions(const uint64_t mem_size, string file_prefix)
+        : mem_size(mem_size), file_prefix(std::move(file_prefix)), io(io_backend::create()) {
+}
+
+customer_partitions::~customer_partitions() {
+    for (size_t partition = 0; partition < writers.size(); partition++) {
+        writers[partition].close();
+        remove(file_name(file_prefix + to_string(partition)).c_str());
+    }
+}
+
+size_t customer_partitions::read_records_for(const uint64_t mem_size) {
+    // The two read ahead blocks take at most a quarter of the budget, a small budget shrinks them
+    return static_cast<size_t>(clamp<uint64_t>(mem_size / 8 / sizeof(partition_record), MIN_PARTITION_READ_RECORDS,
+                                               PARTITION_READ_RECORDS));
+}
+
+uint64_t customer_partitions::table_mem_for(const uint64_t mem_size) {
+    const uint64_t read_ahead_bytes = 2 * read_records_for(mem_size) * sizeof(partition_record);
+    return max<uint64_t>(mem_size - min(mem_size, read_ahead_bytes), 1);
+}
+
+size_t customer_partitions::partitions_for(const uint64_t input_bytes, const uint64_t mem_size) {
+    // Every record may be a new customer, so this is an upper bound of the memory needed
+    const uint64_t state_bytes = input_bytes / log_record::MIN_RECORD_SIZE * TABLE_BYTES_PER_CUSTOMER;
+    const uint64_t table_mem = table_mem_for(mem_size);
+    const uint64_t partitions = (state_bytes + table_mem - 1) / table_mem;
+    // The partitions past what the write buffers allow are partitioned again when loaded
+    const uint64_t max_partitions = clamp<uint64_t>(mem_size / SCATTER_BYTES_PER_PARTITION, 1, MAX_PARTITIONS);
+    return static_cast<size_t>(clamp<uint64_t>(partitions, 1, max_partitions));
+}
+
+size_t customer_partitions::partition_of(const uuid128 &customer_id, const uint64_t divisor, const size_t count) {
+    return ((uuid128_hash()(customer_id) >> 32) / divisor) % count;
+}
+
+bool customer_partitions::open_writers(io_backend &io, vector<write_behind_file> &files, const string &stem_prefix) {
+    for (size_t partition = 0; partition < files.size(); partition++) {
+        const string name = file_name(stem_prefix + to_string(partition));
+        if (!files[partition].open(io, name, PARTITION_WRITE_BUFFER_SIZE)) {
+            cout << "File '" << name << "' cannot be created!" << endl;
+            for (size_t created = 0; created < partition; created++) {
+                files[created].close();
+                remove(file_name(stem_prefix + to_string(created)).c_str());
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool customer_partitions::open(const size_t partitions_count) {
+    writers = vector<write_behind_file>(clamp<size_t>(partitions_count, 1, MAX_PARTITIONS));
+    if (open_writers(*io, writers, file_prefix)) return true;
+    writers.clear();
+    return false;
+}
+
+void customer_partitions::add_log_file(const string &file_name, const uint32_t day,
+                                       page_dictionary &page_ids_dictionary) {
+    const metrics::scoped_timer timer("scatter_day");
+    MappedLogFile log_file;
+    log_file.open(file_name);
+    partition_record record{};
+    record.day = day;
+    size_t malformed_count = 0;
+    for (const auto &log: log_file) {
+        if (!id_helper::parse_uuid(log.customer_id, record.customer_id)) {
+            malformed_count++;
+            continue;
+        }
+        record.page_id = page_ids_dictionary.intern(log.page_id);
+        const size_t partition = partition_of(record.customer_id, 1, writers.size());
+        writers[partition].write(string_view(reinterpret_cast<const char *>(&record), sizeof(record)));
+    }
+    log_file.close();
+    id_helper::report_malformed_ids(file_name, malformed_count);
+}
+
+template<typename Visit>
+bool customer_partitions::for_each_record(const string &name, const size_t read_records, Visit visit) {
+    read_ahead_file partition_file;
+    if (!partition_file.open(*io, name, read_records * sizeof(partition_record))) {
+        cout << "File '" << name << "' cannot be opened!" << endl;
+        return false;
+    }
+    partition_record record{};
+    for (string_view block = partition_file.next_block(); !block.empty(); block = partition_file.next_block())
+        for (size_t offset = 0; offset + sizeof(record) <= block.size(); offset += sizeof(record)) {
+            memcpy(&record, block.data() + offset, sizeof(record));
+            visit(record);
+        }
+    if (partition_file.failed()) {
+        cout << "File '" << name << "' cannot be read!" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool customer_partitions::join_partition(const string &stem, const size_t level, const uint64_t divisor,
+                                         const uint64_t mem_size, vector<uuid128> &loyal_customers) {
+    const string name = file_name(stem);
+    error_code error;
+    const uint64_t file_size = filesystem::file_size(name, error);
+    if (error) {
+        cout << "File '" << name << "' is not found!" << endl;
+        return false;
+    }
+    // Every record may be a new customer, as in partitions_for
+    const uint64_t state_bytes = file_size / sizeof(partition_record) * TABLE_BYTES_PER_CUSTOMER;
+    const uint64_t table_mem = table_mem_for(mem_size);
+    const size_t read_records = read_records_for(mem_size);
+
+    if (state_bytes > table_mem) {
+        // The sub-partitions are written while this one is read, and must leave digits of the hash to the next ones
+        const uint64_t count = min<uint64_t>({(state_bytes + table_mem - 1) / table_mem,
+                                              table_mem / SCATTER_BYTES_PER_PARTITION, MAX_PARTITIONS,
+                                              PARTITION_HASH_VALUES / divisor});
+        if (level < MAX_PARTITION_LEVELS && count >= 2) {
+            vector<write_behind_file> sub_writers(count);
+            const string stem_prefix = stem + "_";
+            if (!open_writers(*io, sub_writers, stem_prefix)) return false;
+            bool ok = for_each_record(name, read_records, [&](const partition_record &record) {
+                const size_t partition = partition_of(record.customer_id, divisor, count);
+                sub_writers[partition].write(string_view(reinterpret_cast<const char *>(&record), sizeof(record)));
+            });
+            remove(name.c_str());
+            for (size_t partition = 0; partition < count; partition++)
+                if (!sub_writers[partition].close() && ok) {
+                    cout << "File '" << file_name(stem_prefix + to_string(partition)) << "' cannot be written!"
+                         << endl;
+                    ok = false;
+                }
+            for (size_t partition = 0; partition < count; partition++) {
+                const string sub_stem = stem_prefix + to_string(partition);
+                if (ok) ok = join_partition(sub_stem, level + 1, divisor * count, mem_size, loyal_customers);
+                else remove(file_name(sub_stem).c_str());
+            }
+            return ok;
+        }
+        cerr << "Partition " << name << " may need up to " << state_bytes << " bytes, over the " << table_mem
+             << " bytes left in the memory budget" << endl;
+    }
+
+    // Records of a partition come day by day, in the order the days were added
+    customer_state_table customers;
+    const bool ok = for_each_record(name, read_records, [&customers](const partition_record &record) {
+        customer_state &state = customers.find_or_insert(record.customer_id);
+        state.visit(record.day, record.page_id);
+    });
+    remove(name.c_str());
+    for (const auto &state: customers.slots())
+        if (state.is_loyal()) loyal_customers.push_back(state.customer_id);
+    return ok;
+}
+
+bool customer_partitions::loyal_customers(const page_dictionary &page_ids_dictionary,
+                                          vector<uuid128> &loyal_customers) {
+    const metrics::scoped_timer timer("join_partitions");
+    bool ok = true;
+    for (size_t partition = 0; partition < writers.size(); partition++)
+        if (!writers[partition].close() && ok) {
+            cout << "File '" << file_name(file_prefix + to_string(partition)) << "' cannot be written!" << endl;
+            ok = false;
+        }
+
+    // The page dictionary stays in memory next to every partition loaded
+    const uint64_t dictionary_bytes = page_ids_dictionary.memory_size();
+    const uint64_t partitions_mem = mem_size - min<uint64_t>(mem_size, dictionary_bytes);
+    loyal_customers.clear();
+    for (size_t partition = 0; ok && partition < writers.size(); partition++)
+        ok = join_partition(file_prefix + to_string(partition), 1, writers.size(), partitions_mem, loyal_customers);
+    sort(loyal_customers.begin(), loyal_customers.end());
+    return ok;
+}
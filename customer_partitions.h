@@ -0,0 +1,138 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_CUSTOMER_PARTITIONS_H
+#define TEST_CUSTOMER_PARTITIONS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "id_helper.h"
+#include "io_backend.h"
+#include "run_file_io.h"
+
+using namespace std;
+
+/**
+ * Grace hash join of day logs on customer id, for more customers than fit in memory and with no sort at all.
+ *
+ * Every visit of every day is scattered by customer id hash into one of the partition files, as a fixed 24 bytes
+ * record. A customer only ever lands in one partition, so each partition is then loaded on its own into a
+ * customer_state_table to decide loyalty. The number of partitions is picked so that one partition's table fits in
+ * the memory budget, next to the write buffers of all the partitions while scattering. A partition still too large
+ * when it is loaded, with the page dictionary taking its share of the budget, is partitioned again the same way.
+ */
+class customer_partitions {
+public:
+    /**
+     * @param mem_size memory budget in bytes
+     * @param file_prefix partition files are named file_prefix + index + ".bin"
+     */
+    explicit customer_partitions(uint64_t mem_size, string file_prefix = "partition_");
+
+    ~customer_partitions();
+
+    /**
+     * Get the number of partitions for one partition's state to fit in the memory budget
+     * @param input_bytes total size of the day logs
+     * @param mem_size memory budget in bytes
+     * @return number of partitions, at least 1 and small enough for the write buffers of all of them to fit in the
+     * budget and to keep all the partition files open
+     */
+    static size_t partitions_for(uint64_t input_bytes, uint64_t mem_size);
+
+    /**
+     * Create the partition files
+     * @param partitions_count number of partition files, every one of them is open while scattering
+     * @return false if a partition file cannot be created
+     */
+    bool open(size_t partitions_count);
+
+    /**
+     * Scatter all the visits of a day log file into the partitions. Days must be added in increasing order
+     * @param file_name day log file name
+     * @param day day of the log file, from 1
+     * @param page_ids_dictionary page id strings interned into dense ordinals
+     */
+    void add_log_file(const string &file_name, uint32_t day, page_dictionary &page_ids_dictionary);
+
+    /**
+     * Load the partitions one at a time and find their loyal customers, removing every partition file once done
+     * @param page_ids_dictionary dictionary the days were added with, it stays in memory next to the partitions
+     * @param loyal_customers output loyal customer ids in ascending order
+     * @return false if a partition file cannot be written or read
+     */
+    bool loyal_customers(const page_dictionary &page_ids_dictionary, vector<uuid128> &loyal_customers);
+
+    size_t size() const { return writers.size(); }
+
+private:
+    struct partition_record {
+        uuid128 customer_id;
+        uint32_t day;
+        page_ordinal page_id;
+    };
+
+    /**
+     * Get the read ahead block of a partition file, scaled to the memory budget
+     * @param mem_size memory budget in bytes
+     * @return records in every one of the two read ahead blocks
+     */
+    static size_t read_records_for(uint64_t mem_size);
+
+    /**
+     * Get the memory left for the table of a partition next to the read ahead blocks of its file
+     * @param mem_size memory budget in bytes
+     * @return memory for the table in bytes
+     */
+    static uint64_t table_mem_for(uint64_t mem_size);
+
+    /**
+     * Get the partition of a customer. Partitions of every level take the next digits of the hash in base count
+     * @param customer_id customer id
+     * @param divisor product of the counts of the levels above
+     * @param count number of partitions of this level
+     * @return partition from 0 to count - 1
+     */
+    static size_t partition_of(const uuid128 &customer_id, uint64_t divisor, size_t count);
+
+    static string file_name(const string &stem) { return stem + ".bin"; }
+
+    /**
+     * Create one partition file per writer, named stem_prefix + index + ".bin"
+     * @return false if a file cannot be created, the files already created are removed
+     */
+    static bool open_writers(io_backend &io, vector<write_behind_file> &files, const string &stem_prefix);
+
+    /**
+     * Find the loyal customers of a partition and remove its file, partitioning it again if it is too large
+     * @param stem partition file name without ".bin"
+     * @param level number of times its records were partitioned before, from 1
+     * @param divisor product of the partition counts of all the levels before
+     * @param mem_size memory budget left next to the page dictionary, in bytes
+     * @param loyal_customers loyal customers found are appended here
+     * @return false if a partition file cannot be read or written
+     */
+    bool join_partition(const string &stem, size_t level, uint64_t divisor, uint64_t mem_size,
+                        vector<uuid128> &loyal_customers);
+
+    /**
+     * Call visit for every record of a partition file, in the order they were written
+     * @param name partition file name
+     * @param read_records records in every read ahead block
+     * @param visit called with every record
+     * @return false if the file cannot be read
+     */
+    template<typename Visit>
+    bool for_each_record(const string &name, size_t read_records, Visit visit);
+
+    const uint64_t mem_size;
+    const string file_prefix;
+    unique_ptr<io_backend> io;
+    vector<write_behind_file> writers;
+};
+
+#endif //TEST_CUSTOMER_PARTITIONS_H
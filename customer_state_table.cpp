@@ -0,0 +1,66 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include "customer_state_table.h"
+#include "metrics.h"
+
+/**
+ * Round up to a power of two, at least 16
+ * @param n number to round up
+ * @return smallest power of two not less than n
+ */
+static size_t round_up_power_of_two(const size_t n) {
+    size_t capacity = 16;
+    while (capacity < n) capacity <<= 1;
+    return capacity;
+}
+
+customer_state_table::customer_state_table(const size_t capacity)
+        : table(round_up_power_of_two(capacity)), mask(table.size() - 1) {}
+
+void customer_state_table::reserve(const size_t customers_count) {
+    if (customers_count * 2 > table.size()) rehash(round_up_power_of_two(customers_count * 2));
+}
+
+customer_state &customer_state_table::find_or_insert(const uuid128 &customer_id) {
+    if ((count + 1) * 2 > table.size()) rehash(table.size() * 2);
+    size_t probes = 1;
+    for (size_t slot = uuid128_hash()(customer_id) & mask;; slot = (slot + 1) & mask, probes++) {
+        customer_state &state = table[slot];
+        if (state.last_day == 0) {
+            // New customer: the caller sets the day right away with visit()
+            state.customer_id = customer_id;
+            count++;
+            metrics::add(metric::hash_probes, probes);
+            return state;
+        }
+        if (state.customer_id == customer_id) {
+            metrics::add(metric::hash_probes, probes);
+            return state;
+        }
+    }
+}
+
+const customer_state *customer_state_table::find(const uuid128 &customer_id) const {
+    size_t probes = 1;
+    for (size_t slot = uuid128_hash()(customer_id) & mask;; slot = (slot + 1) & mask, probes++) {
+        const customer_state &state = table[slot];
+        if (state.last_day == 0 || state.customer_id == customer_id) {
+            metrics::add(metric::hash_probes, probes);
+            return state.last_day == 0 ? nullptr : &state;
+        }
+    }
+}
+
+void customer_state_table::rehash(const size_t capacity) {
+    vector<customer_state> old_table(capacity);
+    old_table.swap(table);
+    mask = table.size() - 1;
+    for (const auto &state: old_table) {
+        if (state.last_day == 0) continue;
+        size_t slot = uuid128_hash()(state.customer_id) & mask;
+        while (table[slot].last_day != 0) slot = (slot + 1) & mask;
+        table[slot] = state;
+    }
+}
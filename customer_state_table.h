@@ -0,0 +1,98 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_CUSTOMER_STATE_TABLE_H
+#define TEST_CUSTOMER_STATE_TABLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "id_helper.h"
+
+using namespace std;
+
+/**
+ * Compact loyalty state of one customer: 32 bytes, two per cache line.
+ */
+struct customer_state {
+    uuid128 customer_id;
+    // Last day the customer came on, 0 marks an empty slot
+    uint32_t last_day = 0;
+    // Number of days the customer came on
+    uint32_t days_count = 0;
+    // First page the customer visited
+    page_ordinal first_page = 0;
+    // The customer visited at least two unique pages
+    bool two_pages = false;
+
+    /**
+     * Fold one visit into the state. Days must be folded in increasing order, all the visits of a day before the
+     * next day, which keeps the state the same size however long the history grows.
+     * @param day day of the visit, from 1
+     * @param page_id page visited
+     */
+    void visit(const uint32_t day, const page_ordinal page_id) {
+        if (last_day == 0)
+            first_page = page_id;
+        else if (page_id != first_page)
+            two_pages = true;
+        if (day != last_day) {
+            last_day = day;
+            days_count++;
+        }
+    }
+
+    /**
+     * Check the loyal customer criteria: came on at least two days and visited at least two unique pages
+     * @return true if the customer is loyal
+     */
+    bool is_loyal() const { return two_pages && days_count >= 2; }
+};
+
+/**
+ * Flat open addressing hash table of customer_state keyed by customer id, with linear probing.
+ *
+ * Slots live in one contiguous array, so a lookup is one hash and usually a single cache line, and nothing is
+ * allocated per customer. The table doubles when it gets half full.
+ */
+class customer_state_table {
+public:
+    explicit customer_state_table(size_t capacity = 1024);
+
+    /**
+     * Make room for customers_count customers without growing
+     * @param customers_count expected number of customers
+     */
+    void reserve(size_t customers_count);
+
+    /**
+     * Find the state of a customer, adding an empty state if the customer is new
+     * @param customer_id customer id
+     * @return state of the customer, valid until the next insert
+     */
+    customer_state &find_or_insert(const uuid128 &customer_id);
+
+    /**
+     * Find the state of a customer
+     * @param customer_id customer id
+     * @return state of the customer or nullptr if the customer is not in the table
+     */
+    const customer_state *find(const uuid128 &customer_id) const;
+
+    size_t size() const { return count; }
+
+    /**
+     * Slots of the table, empty slots have last_day == 0
+     */
+    const vector<customer_state> &slots() const { return table; }
+
+private:
+    void rehash(size_t capacity);
+
+    vector<customer_state> table;
+    size_t mask;
+    size_t count = 0;
+};
+
+#endif //TEST_CUSTOMER_STATE_TABLE_H
@@ -4,30 +4,30 @@
 
 #include <fstream>
 #include "cvs_helper.h"
-#include "string_helper.h"
+#include "mapped_log_file.h"
 
-vector<vector<string>> cvs_helper::read_cvs(const string &file_name) {
-    vector<vector<string>> lines;
-    ifstream file_reader;
+void cvs_helper::read_cvs(const string &file_name, const sort_key_encoder &sort_key, record_arena &lines) {
+    MappedLogFile file_reader;
     file_reader.open(file_name);
-    string line;
-    while (getline(file_reader, line)) {
-        const vector<string> data = string_helper::split(line, ",");
-        lines.push_back(data);
+    // Lines and keys are copied straight into the arena, the key buffer is reused between lines
+    lines.reserve(file_reader.size() * 2);
+    string key;
+    for (auto line = file_reader.begin(); line != file_reader.end(); ++line) {
+        sort_key.encode(line.line(), key);
+        lines.append(line.line(), key);
     }
     file_reader.close();
-    return lines;
 }
 
-void cvs_helper::write_cvs(const string &file_name, const vector<vector<string>> &lines) {
+void cvs_helper::write_cvs(const string &file_name, const record_arena &lines) {
     // Remove file
     remove(file_name.c_str());
 
     ofstream file_writer;
     file_writer.open(file_name);
     if (file_writer.is_open())
-        for (const auto &line: lines) {
-            file_writer << string_helper::join(line, ",") << endl;
+        for (size_t i = 0; i < lines.size(); i++) {
+            file_writer << lines.row(i) << '\n';
         }
     file_writer.close();
-}
\ No newline at end of file
+}
@@ -7,13 +7,32 @@
 
 #include <string>
 
+#include "sort_key.h"
+#include "record_arena.h"
+
 using namespace std;
 
 class cvs_helper {
 public:
-    static vector<vector<string>> read_cvs(const string &file_name);
+    /**
+     * Max number of columns read from a cvs line, the last column keeps the rest of the line
+     */
+    static const size_t MAX_COLUMNS = 16;
+
+    /**
+     * Read the lines of a cvs file with their sort keys into an arena
+     * @param file_name cvs file name
+     * @param sort_key sort key encoder
+     * @param lines output lines, appended to
+     */
+    static void read_cvs(const string &file_name, const sort_key_encoder &sort_key, record_arena &lines);
 
-    static void write_cvs(const string &file_name, const vector<vector<string>> &lines);
+    /**
+     * Write the lines of an arena into a cvs file in their order, one per line
+     * @param file_name cvs file name, replaced
+     * @param lines lines to write
+     */
+    static void write_cvs(const string &file_name, const record_arena &lines);
 };
 
 #endif //TEST_CVS_HELPER_H
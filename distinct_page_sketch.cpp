@@ -0,0 +1,82 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "distinct_page_sketch.h"
+#include "hash_helper.h"
+
+distinct_page_sketch::distinct_page_sketch(const uint8_t precision)
+        : precision(clamp(precision, MIN_PRECISION, MAX_PRECISION)) {}
+
+uint8_t distinct_page_sketch::precision_for_error(const double relative_error) {
+    if (!(relative_error > 0)) return MAX_PRECISION;
+    const double registers_count = pow(1.04 / relative_error, 2);
+    const double precision = ceil(log2(registers_count));
+    return static_cast<uint8_t>(clamp<double>(precision, MIN_PRECISION, MAX_PRECISION));
+}
+
+double distinct_page_sketch::relative_error(const uint8_t precision) {
+    return 1.04 / sqrt(double(size_t(1) << clamp(precision, MIN_PRECISION, MAX_PRECISION)));
+}
+
+bool distinct_page_sketch::add(const string_view page_id) {
+    const size_t h = hash<string_view>()(page_id);
+    const auto page_hash = static_cast<uint32_t>(h ^ (h >> 32));
+    if (!is_exact()) return add_to_registers(page_hash);
+
+    const auto found = lower_bound(page_hashes.begin(), page_hashes.end(), page_hash);
+    if (found != page_hashes.end() && *found == page_hash) return false;
+    // Switch to registers once the set would take more room than them
+    const size_t registers_count = size_t(1) << precision;
+    if (page_hashes.size() < registers_count / sizeof(uint32_t)) {
+        page_hashes.insert(found, page_hash);
+        estimated_count = double(page_hashes.size());
+        return true;
+    }
+    registers.assign(registers_count, 0);
+    for (const uint32_t each_hash: page_hashes) add_to_registers(each_hash);
+    add_to_registers(page_hash);
+    vector<uint32_t>().swap(page_hashes);
+    update_estimate();
+    return true;
+}
+
+bool distinct_page_sketch::add_to_registers(const uint32_t page_hash) {
+    // Spread the 32-bit page hash over 64 bits, distinct pages keep distinct register hashes
+    uint64_t h = hash_helper::mix64(page_hash);
+    const size_t index = h >> (64 - precision);
+    // Rank: position of the first set bit in the remaining bits, capped when they are all zero
+    h <<= precision;
+    uint8_t rank = 1;
+    while (rank <= 64 - precision && (h & (uint64_t(1) << 63)) == 0) {
+        h <<= 1;
+        rank++;
+    }
+    if (registers[index] >= rank) return false;
+    registers[index] = rank;
+    // The estimate of a sketch still being built is refreshed by add
+    if (page_hashes.empty()) update_estimate();
+    return true;
+}
+
+void distinct_page_sketch::update_estimate() {
+    const double registers_count = double(registers.size());
+    double inverse_sum = 0;
+    size_t zero_registers = 0;
+    for (const uint8_t each_register: registers) {
+        inverse_sum += ldexp(1.0, -each_register);
+        if (each_register == 0) zero_registers++;
+    }
+    const double alpha = registers.size() == 16 ? 0.673
+                         : registers.size() == 32 ? 0.697
+                         : registers.size() == 64 ? 0.709
+                         : 0.7213 / (1 + 1.079 / registers_count);
+    estimated_count = alpha * registers_count * registers_count / inverse_sum;
+    // Small range correction: linear counting while some registers are still empty
+    if (estimated_count <= 2.5 * registers_count && zero_registers > 0)
+        estimated_count = registers_count * log(registers_count / double(zero_registers));
+}
@@ -0,0 +1,76 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_DISTINCT_PAGE_SKETCH_H
+#define TEST_DISTINCT_PAGE_SKETCH_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Approximate count of the distinct pages visited by one customer, in at most 2^precision bytes however many pages
+ * the customer browses.
+ *
+ * Up to 2^precision / 4 pages are kept exactly, as a sorted set of 32-bit page hashes. Past that the set is folded
+ * into a HyperLogLog of 2^precision one byte registers, whose relative standard error is 1.04 / sqrt(2^precision).
+ * Pages are hashed from their id strings, so no page dictionary is needed either.
+ */
+class distinct_page_sketch {
+public:
+    static constexpr uint8_t MIN_PRECISION = 4;
+    static constexpr uint8_t MAX_PRECISION = 16;
+
+    /**
+     * @param precision log2 of the number of registers, from MIN_PRECISION to MAX_PRECISION
+     */
+    explicit distinct_page_sketch(uint8_t precision);
+
+    /**
+     * Get the smallest precision whose relative standard error is at most relative_error
+     * @param relative_error wanted relative standard error of the estimate, e.g. 0.05
+     * @return precision, clamped from MIN_PRECISION to MAX_PRECISION
+     */
+    static uint8_t precision_for_error(double relative_error);
+
+    /**
+     * Get the relative standard error of the estimate once a sketch has switched to HyperLogLog
+     * @param precision log2 of the number of registers
+     * @return relative standard error
+     */
+    static double relative_error(uint8_t precision);
+
+    /**
+     * Add one page visit
+     * @param page_id page id string
+     * @return true if the estimate may have changed
+     */
+    bool add(string_view page_id);
+
+    /**
+     * Estimated number of distinct pages added, exact while in the small set
+     */
+    double estimate() const { return estimated_count; }
+
+    /**
+     * The sketch still counts exactly
+     */
+    bool is_exact() const { return registers.empty(); }
+
+private:
+    bool add_to_registers(uint32_t page_hash);
+
+    void update_estimate();
+
+    uint8_t precision;
+    double estimated_count = 0;
+    // Sorted page hashes while exact, released when switching to registers
+    vector<uint32_t> page_hashes;
+    // HyperLogLog registers, empty while exact
+    vector<uint8_t> registers;
+};
+
+#endif //TEST_DISTINCT_PAGE_SKETCH_H
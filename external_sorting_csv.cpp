@@ -6,13 +6,25 @@
 #include <utility>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 #include <ctime>
-#include <queue>
+#include <chrono>
 #include <random>
+#include <filesystem>
+#include <thread>
+#include <functional>
 
 #include "string_helper.h"
+#include "blocking_queue.h"
+#include "loser_tree.h"
+#include "sort_key.h"
+#include "record_arena.h"
+#include "columnar_log_file.h"
+#include "mapped_log_file.h"
+#include "run_file_io.h"
+#include "workload_generator.h"
+#include "metrics.h"
+#include "merge_planner.h"
 
 using namespace std;
 
@@ -49,93 +61,381 @@ using namespace std;
  * distribution. This approach, on average, produced half the number of output chunks, each twice the length.
  *
  */
-static const size_t SIZEOF_CHAR = sizeof(char);
-
-const clock_t begin_time = clock();
-
-void generate_csv_log_file(const string &file_name, const long file_size) {
-    // Get start date
-    time_t start_time;
-    time(&start_time);
-    tm *local_time = localtime(&start_time);
-    local_time->tm_hour = -1;
-    local_time->tm_min = -1;
-    local_time->tm_sec = -1;
-    start_time = mktime(local_time);
-    cout << ctime(&start_time);
-
-    // Get end date
-    local_time->tm_mday += 1;
-    const time_t end_time = mktime(local_time);
-    cout << ctime(&end_time);
-    const long period = end_time - start_time;
-    // day_time generator
-    default_random_engine generator(chrono::steady_clock::now().time_since_epoch().count());
-    uniform_int_distribution<long> day_time_distribution(0, period);
-
-    // Generate page ids & customer ids
-    string page_ids[2000];
-    string customer_ids[500];
-    for (auto &page_id: page_ids)
-        page_id = string_helper::generate_random_string(16);
-    for (auto &customer_id: customer_ids)
-        customer_id = string_helper::generate_uuid_v4();
-    // page_id generator and customer_id generator
-    uniform_int_distribution<long> page_id_distribution(0, size(page_ids) - 1);
-    uniform_int_distribution<long> customer_id_distribution(0, size(customer_ids) - 1);
-
-    // Remove the old file
-    filesystem::remove(file_name.c_str());
-    // Create output cvs log file
-    ofstream output;
-    output.open(file_name.c_str());
-
-    // Generate log in cvs format: timestamp, page_id, customer_id
-    unsigned long total_size_so_far = 0;
-    unsigned long sentence_size;
-    while (total_size_so_far < file_size) {
-        const long timestamp = start_time + day_time_distribution(generator);
-        auto t1 = page_id_distribution(generator);
-        const string page_id = page_ids[t1];
-        auto t2 = customer_id_distribution(generator);
-        const string customer_id = customer_ids[t2];
-        cout << t1 << "=" << page_id << "," << t2 << "=" << customer_id << endl;
-
-        stringstream ss;
-        ss << timestamp << "," << page_id << "," << customer_id << endl;
-        sentence_size = ss.str().size() * SIZEOF_CHAR;
-        output << ss.str();
-        total_size_so_far += sentence_size;
+// Default read ahead block of every run file during the merge, two of them per run: with the memory budget it sets
+// the fan-in of the merge
+static const size_t RUN_READ_BLOCK_SIZE = 512 * 1024;
+// Sorted runs are written in buffers of this size, two of them per run file
+static const size_t RUN_WRITE_BUFFER_SIZE = 1024 * 1024;
+// Merged rows are written out in batches of at most this size, two of them for the merge output
+static const size_t OUTPUT_BUFFER_SIZE = 4 * 1024 * 1024;
+// Smallest read ahead block and output buffer of the merge, for a small memory budget
+static const size_t MIN_MERGE_BLOCK_SIZE = 4 * 1024;
+// Generated records: 13 digit timestamp, 16-char page id, 36-char customer id, two delimiters and a new line
+static const size_t GENERATED_RECORD_SIZE = 13 + 16 + 36 + 3;
+
+// Wall time of the whole process, the processor time of all the threads would add up
+const chrono::steady_clock::time_point begin_time = chrono::steady_clock::now();
+
+/**
+ * Milliseconds since the process started
+ */
+float elapsed_milliseconds() {
+    return chrono::duration<float, milli>(chrono::steady_clock::now() - begin_time).count();
+}
+
+/**
+ * Generate a cvs log file of about file_size bytes: one day of 500 customers visiting 2000 pages, drawn uniformly.
+ * Records are formatted by all the hardware threads, and the file only depends on the seed.
+ * @param file_name file to generate, replaced
+ * @param file_size size of the file in bytes
+ * @param seed random seed
+ */
+void generate_csv_log_file(const string &file_name, const size_t file_size, const uint64_t seed = 42) {
+    workload_config config;
+    config.customers = 500;
+    config.pages = 2000;
+    config.days = 1;
+    config.customer_skew = 0;
+    config.page_skew = 0;
+    config.churn = 0;
+    config.seed = seed;
+    config.records_per_day = (file_size + GENERATED_RECORD_SIZE - 1) / GENERATED_RECORD_SIZE;
+
+    const metrics::scoped_timer timer("generate");
+    const long long bytes_written = workload_generator(config).write_day(1, file_name);
+    if (bytes_written < 0) {
+        cout << "File " << file_name << " cannot be generated!" << endl;
+        return;
     }
+    cout << "File " << file_name << " has been generated with " << config.records_per_day << " records, "
+         << bytes_written << " bytes: " << elapsed_milliseconds() << " milliseconds." << endl;
+}
+
+/**
+ * How input_cvs_file generates the sorted runs
+ */
+enum class run_strategy {
+    // Read a chunk, sort it, write it
+    load_sort,
+    // Read, sort and write chunks on different threads
+    pipelined,
+    // Replacement selection through a heap, runs about twice the memory size
+    replacement_selection
+};
 
-    output.close();
-    cout << "File " << file_name << " has been generated: " << float(clock() - begin_time) / CLOCKS_PER_SEC * 1000
-         << " milliseconds." << endl;
+/**
+ * Reads the next input row into its argument, returns false at the end of the input
+ */
+using row_reader = function<bool(string &)>;
+
+/**
+ * Read the next input row and build its sort key
+ * @param read_row reads the next input row
+ * @param sort_key sort key encoder
+ * @param keyed output row, its buffers are reused
+ * @return false at the end of the input
+ */
+bool read_keyed_row(const row_reader &read_row, const sort_key_encoder &sort_key, keyed_row &keyed) {
+    if (!read_row(keyed.row)) return false;
+    sort_key.encode(keyed.row, keyed.key);
+    return true;
 }
 
-bool comparator(const vector<int> &sort_array, const vector<string> &row1, const vector<string> &row2) {
-    for (auto &sort_column: sort_array)
-        if (sort_column >= 0 && sort_column < row1.size() && sort_column < row2.size() &&
-            row1.at(sort_column) != row2.at(sort_column))
-            return row1.at(sort_column) < row2.at(sort_column);
-    return false;
+/**
+ * Get the file name of a run
+ * @param run_number run number, from 1
+ * @return run_<run_number>.csv
+ */
+string run_file_name(const int run_number) {
+    return "run_" + to_string(run_number) + ".csv";
 }
 
-struct HeapNode {
-    string sentence;
-    int index;
-    vector<int> sort_array;
+/**
+ * Remove run files, the ones missing are skipped
+ * @param first_run_number first run number
+ * @param last_run_number last run number
+ */
+void remove_run_files(const int first_run_number, const int last_run_number) {
+    error_code error;
+    for (int run_number = first_run_number; run_number <= last_run_number; run_number++)
+        filesystem::remove(run_file_name(run_number), error);
+}
 
-    HeapNode(string a, int b, vector<int> c) : sentence(std::move(a)), index(b), sort_array(std::move(c)) {}
+/**
+ * Start writing sorted rows into run_<run_number>.csv, the last line doesn't have a new line. The rows are copied into
+ * the buffers of run_cvs_file_output, so they can be cleared as soon as this returns
+ * @param run_cvs_file_output run file, its last writes are still in flight until finish_run
+ * @param io I/O backend of the calling thread
+ * @param run_number run number
+ * @param rows sorted rows
+ * @return false if the run cannot be created
+ */
+bool start_run(write_behind_file &run_cvs_file_output, io_backend &io, const int run_number,
+               const record_arena &rows) {
+    const string run_name = run_file_name(run_number);
+    cout << "Writing " << run_name << endl;
+    metrics::add(metric::runs_written);
+    if (!run_cvs_file_output.open(io, run_name, RUN_WRITE_BUFFER_SIZE)) {
+        cout << "File '" << run_name << "' cannot be created!" << endl;
+        return false;
+    }
 
-    bool operator<(const HeapNode &rhs) const {
-        const auto row1 = string_helper::split(rhs.sentence, ",");
-        const auto row2 = string_helper::split(sentence, ",");
-        return comparator(sort_array, row1, row2);
+    const size_t data_size = rows.size();
+    for (size_t i = 0; i + 1 < data_size; i++) {
+        run_cvs_file_output.write(rows.row(i));
+        run_cvs_file_output.put('\n');
     }
-};
+    // Last line don't have a new line
+    if (data_size > 0)
+        run_cvs_file_output.write(rows.row(data_size - 1));
+    run_cvs_file_output.flush();
+    return true;
+}
+
+/**
+ * Wait for the writes of a run started by start_run
+ * @param run_cvs_file_output run file, nothing to wait for if it has not been opened
+ * @param run_number run number
+ * @return false if the run cannot be written
+ */
+bool finish_run(write_behind_file &run_cvs_file_output, const int run_number) {
+    if (!run_cvs_file_output.close()) {
+        cout << "File '" << run_file_name(run_number) << "' cannot be written!" << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Write sorted rows into run_<run_number>.csv and wait for the writes
+ * @param io I/O backend of the calling thread
+ * @param run_number run number
+ * @param rows sorted rows
+ * @return false if the run cannot be written
+ */
+bool write_run(io_backend &io, const int run_number, const record_arena &rows) {
+    write_behind_file run_cvs_file_output;
+    return start_run(run_cvs_file_output, io, run_number, rows) && finish_run(run_cvs_file_output, run_number);
+}
+
+/**
+ * Generate sorted runs one at a time: read a chunk up to total_mem, sort it, write it, then read the next chunk. The
+ * last writes of a run, up to one buffer, are still in flight while the next chunk is read
+ * @param read_row reads the next input row
+ * @param total_mem memory for one chunk in bytes
+ * @param sort_key sort key encoder
+ * @return number of runs, or -1 if a run cannot be written
+ */
+int generate_runs(const row_reader &read_row, const size_t total_mem, const sort_key_encoder &sort_key) {
+    int run_count = 0;
+
+    // Rows are kept as whole lines next to their sort keys, in one slab reused by every run
+    record_arena rows(total_mem);
+    // A run is closed once the next chunk is read, so its last buffer is written in the background meanwhile
+    const unique_ptr<io_backend> io = io_backend::create();
+    write_behind_file run_cvs_file_output;
+
+    keyed_row keyed;
+    while (read_keyed_row(read_row, sort_key, keyed)) {
+        if (rows.mem_size() + record_arena::record_size(keyed.row, keyed.key) > total_mem && !rows.empty()) {
+            // Sort in memory
+            rows.sort();
+            if (!finish_run(run_cvs_file_output, run_count) ||
+                !start_run(run_cvs_file_output, *io, ++run_count, rows)) {
+                remove_run_files(1, run_count);
+                return -1;
+            }
+
+            // New run started
+            rows.clear();
+        }
+        // Add into rows for sort in memory
+        rows.append(keyed.row, keyed.key);
+    }
+
+    if (!rows.empty()) {
+        rows.sort();
+        if (!finish_run(run_cvs_file_output, run_count) ||
+            !start_run(run_cvs_file_output, *io, ++run_count, rows)) {
+            remove_run_files(1, run_count);
+            return -1;
+        }
+    }
+    if (!finish_run(run_cvs_file_output, run_count)) {
+        remove_run_files(1, run_count);
+        return -1;
+    }
+
+    return run_count;
+}
+
+/**
+ * Generate sorted runs with a pipeline, so reading, sorting and writing overlap: this thread reads chunks, sort_threads
+ * workers sort them and a writer thread writes the runs.
+ *
+ * The memory budget is shared by all the chunks in flight: one being read, one per sort worker and one being written,
+ * so every chunk gets total_mem / (sort_threads + 2). Chunks are recycled through a pool, so the reader waits when
+ * all of them are busy.
+ * @param read_row reads the next input row
+ * @param total_mem memory for all the chunks in bytes
+ * @param sort_key sort key encoder
+ * @param sort_threads number of sort worker threads
+ * @return number of runs, or -1 if a run cannot be written
+ */
+int generate_runs_pipelined(const row_reader &read_row, const size_t total_mem, const sort_key_encoder &sort_key,
+                            const int sort_threads) {
+    struct run_chunk {
+        int run_number = 0;
+        record_arena rows;
+    };
+
+    const size_t chunks_count = sort_threads + 2;
+    const size_t chunk_mem = total_mem / chunks_count;
+    vector<run_chunk> chunks(chunks_count);
+    blocking_queue<run_chunk *> free_chunks, sort_queue, write_queue;
+    for (auto &chunk: chunks) {
+        chunk.rows.reserve(chunk_mem);
+        free_chunks.push(&chunk);
+    }
+
+    vector<thread> sorters;
+    for (int i = 0; i < sort_threads; i++)
+        sorters.emplace_back([&]() {
+            run_chunk *chunk;
+            while (sort_queue.pop(chunk)) {
+                chunk->rows.sort();
+                write_queue.push(chunk);
+            }
+        });
+    // Once a run fails the next ones are only recycled, so the reader still gets its chunks back
+    bool write_failed = false;
+    thread writer([&]() {
+        const unique_ptr<io_backend> io = io_backend::create();
+        run_chunk *chunk;
+        while (write_queue.pop(chunk)) {
+            if (!write_failed && !write_run(*io, chunk->run_number, chunk->rows)) write_failed = true;
+            chunk->rows.clear();
+            free_chunks.push(chunk);
+        }
+    });
+
+    int run_count = 0;
+    run_chunk *chunk = nullptr;
+    free_chunks.pop(chunk);
+    keyed_row keyed;
+    while (read_keyed_row(read_row, sort_key, keyed)) {
+        if (chunk->rows.mem_size() + record_arena::record_size(keyed.row, keyed.key) > chunk_mem &&
+            !chunk->rows.empty()) {
+            chunk->run_number = ++run_count;
+            sort_queue.push(chunk);
+            // Wait for a free chunk when all of them are in flight
+            free_chunks.pop(chunk);
+        }
+        chunk->rows.append(keyed.row, keyed.key);
+    }
+    if (!chunk->rows.empty()) {
+        chunk->run_number = ++run_count;
+        sort_queue.push(chunk);
+    }
+
+    sort_queue.close();
+    for (auto &sorter: sorters) sorter.join();
+    write_queue.close();
+    writer.join();
+
+    if (write_failed) {
+        remove_run_files(1, run_count);
+        return -1;
+    }
+    return run_count;
+}
+
+/**
+ * Generate sorted runs with replacement selection: a heap holds total_mem worth of rows, the smallest row that can
+ * still extend the current run is written out and replaced by the next input row. A row smaller than the last one
+ * written has to wait for the next run. On random input runs come out about twice total_mem long, halving the number
+ * of runs to merge; already sorted input becomes one single run.
+ * @param read_row reads the next input row
+ * @param total_mem memory for the heap in bytes
+ * @param sort_key sort key encoder
+ * @return number of runs, or -1 if a run cannot be written
+ */
+int generate_runs_replacement_selection(const row_reader &read_row, const size_t total_mem,
+                                        const sort_key_encoder &sort_key) {
+    struct selection_node {
+        int run_number;
+        keyed_row keyed;
+    };
+    // Heap functions keep the largest on top: order by run first, then by the sort key, both reversed. pop_heap moves
+    // the top to the back, where the row can be moved out instead of copied as with priority_queue::top
+    size_t comparisons = 0;
+    const auto node_comparator = [&comparisons](const selection_node &node1, const selection_node &node2) {
+        comparisons++;
+        if (node1.run_number != node2.run_number) return node1.run_number > node2.run_number;
+        return node2.keyed < node1.keyed;
+    };
+    vector<selection_node> heap;
+
+    // Fill the heap up to the memory budget
+    size_t total_mem_so_far = 0;
+    keyed_row keyed;
+    while (total_mem_so_far < total_mem && read_keyed_row(read_row, sort_key, keyed)) {
+        total_mem_so_far += keyed.mem_size();
+        heap.push_back({1, std::move(keyed)});
+    }
+    make_heap(heap.begin(), heap.end(), node_comparator);
 
-int input_cvs_file(const string &input_csv_file_name, const long total_mem, const vector<int> &sort_array) {
+    int run_count = 0;
+    // Rows are written in the background while the heap keeps selecting
+    const unique_ptr<io_backend> io = io_backend::create();
+    write_behind_file run_cvs_file_output;
+    string last_key;
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), node_comparator);
+        selection_node node = std::move(heap.back());
+        heap.pop_back();
+        if (node.run_number != run_count) {
+            // Current run is exhausted, start the next one
+            if (!run_cvs_file_output.close()) {
+                cout << "File '" << run_file_name(run_count) << "' cannot be written!" << endl;
+                remove_run_files(1, run_count);
+                return -1;
+            }
+            run_count = node.run_number;
+            const string run_name = run_file_name(run_count);
+            cout << "Writing " << run_name << endl;
+            metrics::add(metric::runs_written);
+            if (!run_cvs_file_output.open(*io, run_name, RUN_WRITE_BUFFER_SIZE)) {
+                cout << "File '" << run_name << "' cannot be created!" << endl;
+                remove_run_files(1, run_count);
+                return -1;
+            }
+        } else {
+            // Last line don't have a new line
+            run_cvs_file_output.put('\n');
+        }
+        run_cvs_file_output.write(node.keyed.row);
+        last_key = std::move(node.keyed.key);
+
+        // Replace the row written by the next input row
+        if (read_keyed_row(read_row, sort_key, keyed)) {
+            const int run_number = keyed.key < last_key ? run_count + 1 : run_count;
+            heap.push_back({run_number, std::move(keyed)});
+            push_heap(heap.begin(), heap.end(), node_comparator);
+        }
+    }
+    metrics::add(metric::heap_comparisons, comparisons);
+    if (!run_cvs_file_output.close()) {
+        cout << "File '" << run_file_name(run_count) << "' cannot be written!" << endl;
+        remove_run_files(1, run_count);
+        return -1;
+    }
+
+    return run_count;
+}
+
+int input_cvs_file(const string &input_csv_file_name, const size_t total_mem, const sort_key_encoder &sort_key,
+                   const run_strategy strategy, const int sort_threads) {
     ifstream input_cvs_file_stream;
     input_cvs_file_stream.open(input_csv_file_name.c_str());
 
@@ -151,207 +451,296 @@ int input_cvs_file(const string &input_csv_file_name, const long total_mem, cons
     cout << "-------------------------------------------------------" << endl;
     cout << "The size of the file chosen is (in bytes): " << input_file_size << endl;
 
-    int run_count = 0;
-    unsigned long total_mem_so_far = 0;
-
-    vector<vector<string>> rows;
-
     cout << "File " << input_csv_file_name << " is being read!" << endl;
     cout << "-------------------------------------------------------\n\n" << endl;
 
     cout << "-------------------------------------------------------" << endl;
-    while (!input_cvs_file_stream.eof()) {
-        string line;
-        getline(input_cvs_file_stream, line);
-        if (total_mem_so_far + line.size() * SIZEOF_CHAR < total_mem) {
-            // Add into rows for sort in memory
-            total_mem_so_far += line.size() * SIZEOF_CHAR + 1;
-            rows.push_back(string_helper::split(line, ","));
-        } else {
-            // Sort in memory
-            sort(rows.begin(), rows.end(),
-                 [&sort_array](vector<string> &row1, vector<string> &row2) {
-                     return comparator(sort_array, row1, row2);
-                 });
-
-            run_count++;
-            stringstream string_stream;
-            string_stream << "run_" << run_count << ".csv";
-            cout << "Writing " << string_stream.str() << endl;
-            ofstream run_cvs_file_output_stream;
-            run_cvs_file_output_stream.open(string_stream.str());
-
-            unsigned long data_size = rows.size();
-            for (int i = 0; i < data_size - 1; i++)
-                run_cvs_file_output_stream << string_helper::join(rows[i], ",") << endl;
-            // Last line don't have a new line
-            if (data_size > 0)
-                run_cvs_file_output_stream << string_helper::join(rows[data_size - 1], ",");
-            run_cvs_file_output_stream.close();
-
-            // New run started
-            rows.clear();
-            total_mem_so_far = line.size() * SIZEOF_CHAR;
-            rows.push_back(string_helper::split(line, ","));
-        }
-    }
     input_cvs_file_stream.close();
-
-    if (!rows.empty()) {
-        sort(rows.begin(), rows.end(),
-             [sort_array](vector<string> &row1, vector<string> &row2) {
-                 return comparator(sort_array, row1, row2);
-             });
-
-        run_count++;
-        stringstream string_stream;
-        string_stream << "run_" << run_count << ".csv";
-        cout << "Writing " << string_stream.str() << endl;
-        ofstream run_cvs_file_output_stream;
-        run_cvs_file_output_stream.open(string_stream.str());
-
-        unsigned long data_size = rows.size();
-        for (int i = 0; i < data_size - 1; i++) {
-            run_cvs_file_output_stream << string_helper::join(rows[i], ",");
-            run_cvs_file_output_stream << endl;
-        }
-        // Last line don't have a new line
-        run_cvs_file_output_stream << string_helper::join(rows[data_size - 1], ",");
-        run_cvs_file_output_stream.close();
+    // Columnar day logs are read from their columns and formatted back into cvs rows
+    ColumnarLogFile columnar_file;
+    size_t block_index = 0, record_index = 0;
+    // Cvs rows are cut at the new lines found by the vectorized scan of MappedLogFile
+    MappedLogFile cvs_file;
+    MappedLogFile::iterator cvs_row, cvs_end;
+    row_reader read_row;
+    if (ColumnarLogFile::is_columnar(input_csv_file_name) && columnar_file.open(input_csv_file_name)) {
+        read_row = [&columnar_file, &block_index, &record_index](string &row) {
+            for (; block_index < columnar_file.blocks_count(); block_index++, record_index = 0)
+                if (record_index < columnar_file.get_block(block_index).records_count) {
+                    columnar_file.format_row(columnar_file.get_block(block_index), record_index++, row);
+                    return true;
+                }
+            return false;
+        };
+    } else {
+        cvs_file.open(input_csv_file_name);
+        cvs_row = cvs_file.begin();
+        cvs_end = cvs_file.end();
+        read_row = [&cvs_row, &cvs_end](string &row) {
+            if (cvs_row == cvs_end) return false;
+            row.assign(cvs_row.line());
+            ++cvs_row;
+            return true;
+        };
     }
+    int run_count;
+    const metrics::scoped_timer timer("run_generation");
+    switch (strategy) {
+        case run_strategy::pipelined:
+            run_count = generate_runs_pipelined(read_row, total_mem, sort_key, sort_threads);
+            break;
+        case run_strategy::replacement_selection:
+            run_count = generate_runs_replacement_selection(read_row, total_mem, sort_key);
+            break;
+        default:
+            run_count = generate_runs(read_row, total_mem, sort_key);
+    }
+    cvs_file.close();
 
     cout << "Read '" << input_csv_file_name << "' is done!" << endl;
-    cout << "Entire process so far took a total of: " << float(clock() - begin_time) / CLOCKS_PER_SEC * 1000
-         << " milliseconds." << endl;
+    cout << "Entire process so far took a total of: " << elapsed_milliseconds() << " milliseconds." << endl;
     cout << "-------------------------------------------------------\n\n" << endl;
 
     return run_count;
 }
 
-void merge_csv_files(int start, int end, int location, const vector<int> &sort_array) {
-
-    const int runs_count = end - start + 1;
-
-    ifstream input[runs_count];
-    for (int i = 0; i < runs_count; i++) {
-        stringstream string_stream;
-        string_stream << "run_" << start + i << ".csv";
-        input[i].open(string_stream.str());
+/**
+ * Sequential reader of one run file for the merge, with blocks read ahead and the sort key of its current row
+ */
+struct run_reader {
+    run_line_reader lines;
+    string_view row;
+    string key;
+    bool exhausted = false;
+
+    /**
+     * @return false if the run cannot be opened
+     */
+    bool open(io_backend &io, const string &file_name, const size_t read_block_size) {
+        return lines.open(io, file_name, read_block_size);
     }
 
-    // A priority queue is a container adaptor that provides constant time lookup of the largest (by default) element,
-    // at the expense of logarithmic insertion and extraction.
-    priority_queue<HeapNode, vector<HeapNode> > heap;
-
-    ofstream cvs_log_output_stream;
-    stringstream string_stream;
-    string_stream << "run_" << location << ".csv";
-    cvs_log_output_stream.open(string_stream.str());
+    /**
+     * Read the next row and build its sort key
+     * @param sort_key sort key encoder
+     * @return false once the run is exhausted
+     */
+    bool next(const sort_key_encoder &sort_key) {
+        if (!lines.next_line(row)) {
+            exhausted = true;
+            return false;
+        }
+        sort_key.encode(row, key);
+        return true;
+    }
+};
 
-    for (int index = 0; index < runs_count; index++) {
-        string line;
-        if (!input[index].eof()) {
-            getline(input[index], line);
-            heap.emplace(line, index, sort_array);
+/**
+ * Merge sorted runs into one sorted file
+ * @param input_names run files, in the order they were made
+ * @param output_name merged file
+ * @param sort_key sort key encoder
+ * @param read_block_size read ahead block of every run
+ * @param output_buffer_size output buffer, two of them
+ * @return false if a run cannot be read or the merged file cannot be written
+ */
+bool merge_csv_files(const vector<string> &input_names, const string &output_name, const sort_key_encoder &sort_key,
+                     const size_t read_block_size, const size_t output_buffer_size) {
+    const metrics::scoped_timer timer("merge");
+
+    const size_t runs_count = input_names.size();
+
+    // Reads of all the runs and writes of the output overlap with the merge
+    const unique_ptr<io_backend> io = io_backend::create();
+    vector<run_reader> input(runs_count);
+    for (size_t i = 0; i < runs_count; i++) {
+        if (!input[i].open(*io, input_names[i], read_block_size)) {
+            cout << "File '" << input_names[i] << "' cannot be opened!" << endl;
+            return false;
         }
+        input[i].next(sort_key);
     }
 
-    cout << "-------------------------------------------------------" << endl;
-    cout << endl << "Merging from run_" << start << " to run_" << end << " into run_" << location << " file" << endl;
+    // Exhausted runs lose every match, equal keys go to the older run
+    const auto less = [&input](const size_t run1, const size_t run2) {
+        if (input[run1].exhausted || input[run2].exhausted) return !input[run1].exhausted && input[run2].exhausted;
+        const int result = input[run1].key.compare(input[run2].key);
+        return result < 0 || (result == 0 && run1 < run2);
+    };
+    loser_tree<decltype(less)> tree(runs_count, less);
+    tree.build();
+
+    write_behind_file cvs_log_output;
+    // Rows are batched and written output_buffer_size at a time
+    if (!cvs_log_output.open(*io, output_name, output_buffer_size)) {
+        cout << "File '" << output_name << "' cannot be created!" << endl;
+        return false;
+    }
 
-    while (!heap.empty()) {
-        string line = heap.top().sentence;
-        int index = heap.top().index;
-        heap.pop();
+    cout << "-------------------------------------------------------" << endl;
+    cout << endl << "Merging " << runs_count << " runs from " << input_names.front() << " into " << output_name
+         << " file through " << io->name() << endl;
 
-        cvs_log_output_stream << line << endl;
+    while (runs_count > 0 && !input[tree.winner()].exhausted) {
+        run_reader &winner = input[tree.winner()];
+        cvs_log_output.write(winner.row);
+        cvs_log_output.put('\n');
 
-        if (!input[index].eof()) {
-            getline(input[index], line);
-            heap.emplace(line, index, sort_array);
-        }
+        winner.next(sort_key);
+        tree.replay();
     }
 
     cout << "Merge done!\n" << endl;
     cout << "-------------------------------------------------------\n\n" << endl;
 
-    for (int i = 0; i < runs_count; i++)
-        input[i].close();
+    // A run that failed to read ends early, the rows after the failure would be missing from the output
+    bool read_failed = false;
+    for (size_t i = 0; i < runs_count; i++) {
+        if (input[i].lines.failed()) {
+            cout << "File '" << input_names[i] << "' cannot be read!" << endl;
+            read_failed = true;
+        }
+        input[i].lines.close();
+    }
 
-    cvs_log_output_stream.close();
+    metrics::add(metric::heap_comparisons, tree.comparisons_count());
+    if (!cvs_log_output.close() && !read_failed) {
+        cout << "File '" << output_name << "' cannot be written!" << endl;
+        return false;
+    }
+    return !read_failed;
 }
 
-void merge_cvs_files(const int runs_count, const string &output_name, const vector<int> &sort_array) {
+/**
+ * Merge all the sorted runs into the output file, following the plan of merge_planner for the memory budget. Every
+ * run file is removed once it has been merged, and the last merge writes the output file itself.
+ * @param runs_count number of sorted runs, run_1.csv to run_<runs_count>.csv
+ * @param output_name sorted output file
+ * @param sort_key sort key encoder
+ * @param total_mem memory for the merge in bytes
+ * @param read_block_size read ahead block of every run, smaller if the memory budget is too small for it
+ * @return false if a merge failed, every run file is removed then
+ */
+bool merge_cvs_files(const int runs_count, const string &output_name, const sort_key_encoder &sort_key,
+                     const size_t total_mem, const size_t read_block_size) {
+    // Runs made by the merges are numbered after the sorted runs
+    vector<string> run_names;
+    vector<uint64_t> run_sizes;
+    for (int run_number = 1; run_number <= runs_count; run_number++) {
+        run_names.push_back(run_file_name(run_number));
+        error_code error;
+        run_sizes.push_back(filesystem::file_size(run_names.back(), error));
+        if (error) {
+            cout << "File '" << run_names.back() << "' is not found!" << endl;
+            remove_run_files(1, runs_count);
+            return false;
+        }
+    }
+    // The smallest merge, two runs with two read ahead blocks each next to the two output buffers, must fit in the
+    // budget: a small budget shrinks the blocks, down to MIN_MERGE_BLOCK_SIZE
+    const size_t block_size = min(read_block_size, max(total_mem / 6, MIN_MERGE_BLOCK_SIZE));
+    // Output buffers take at most a quarter of the budget, leaving the rest to the runs
+    const size_t output_buffer_size = max(min(total_mem / 8, OUTPUT_BUFFER_SIZE), block_size);
+    const size_t min_mem_size = 4 * block_size + 2 * output_buffer_size;
+    if (min_mem_size > total_mem)
+        cerr << "Memory budget of " << total_mem << " bytes is below the " << min_mem_size << " bytes the merge needs"
+             << endl;
+    const size_t fan_in = merge_planner::fan_in_for(total_mem, block_size, output_buffer_size);
+    const merge_plan plan = merge_planner::plan(run_sizes, fan_in);
 
     cout << "-------------------------------------------------------" << endl;
-    cout << "Merging " << runs_count << " files into output (" << output_name << " file)" << endl;
+    cout << "Merging " << runs_count << " files into output (" << output_name << " file) with a fan-in of " << fan_in
+         << ": " << plan.steps.size() << " merges, " << plan.passes << " passes, " << plan.bytes_written
+         << " bytes written" << endl;
     cout << "-------------------------------------------------------\n\n" << endl;
+    metrics::add(metric::merge_passes, plan.passes);
+
+    for (size_t i = 0; i < plan.steps.size(); i++) {
+        const merge_step &step = plan.steps[i];
+        vector<string> input_names;
+        for (const size_t run: step.inputs) input_names.push_back(run_names[run]);
+        run_names.push_back(i + 1 == plan.steps.size() ? output_name : run_file_name(int(step.output) + 1));
+        if (!merge_csv_files(input_names, run_names.back(), sort_key, block_size, output_buffer_size)) {
+            // Runs merged already are gone, the others and the partly merged file are removed
+            error_code error;
+            for (const auto &run_name: run_names) filesystem::remove(run_name, error);
+            return false;
+        }
 
-    int start = 1;
-    int end = runs_count;
-    while (start < end) {
-        int location = end;
-        int distance = 100;
-        int time = (end - start + 1) / distance + 1;
-        if ((end - start + 1) / time < distance)
-            distance = (end - start + 1) / time + 1;
-        while (start <= end) {
-            int mid = min(start + distance, end);
-            location++;
-            merge_csv_files(start, mid, location, sort_array);
-            start = mid + 1;
+        for (const auto &input_name: input_names) {
+            cout << "Removing " << input_name << endl;
+            filesystem::remove(input_name);
         }
-        end = location;
     }
 
-    stringstream string_stream;
-    string_stream << "run_" << start << ".csv";
-    rename(string_stream.str().c_str(), output_name.c_str());
-
-    cout << "-------------------------------------------------------" << endl;
-    cout << "Removing chucks files!" << endl;
-    for (int i = 1; i < end; i++) {
-        string_stream.clear();
-        string_stream << "run_" << i << ".csv";
-        cout << "Removing " << string_stream.str() << endl;
-        filesystem::remove(string_stream.str().c_str());
+    // Nothing to merge: the only run is the output, or the input was empty
+    if (plan.steps.empty()) {
+        error_code error;
+        if (runs_count == 1) filesystem::rename(run_names.front(), output_name, error);
+        const bool written = runs_count == 1 ? !error : bool(ofstream(output_name, ios::trunc));
+        if (!written) {
+            cout << "File '" << output_name << "' cannot be written!" << endl;
+            if (runs_count == 1) filesystem::remove(run_names.front(), error);
+            return false;
+        }
     }
-    cout << "-------------------------------------------------------\n\n" << endl;
+    return true;
 }
 
 int main(const int argc, const char *argv[]) {
-    if (argc > 0) {
+    metrics::start("ExternalSortingCSV");
+    if (argc > 1) {
         const string input_name = argv[1];
 
-        if (argc == 3) {
-            const long total_mem = strtol(argv[2], nullptr, 0); // bytes
-            generate_csv_log_file(input_name, total_mem);
+        if (argc == 3 || (argc == 5 && string(argv[3]) == "--seed")) {
+            const size_t file_size = max(strtol(argv[2], nullptr, 0), 0L); // bytes, 0 if negative
+            const uint64_t seed = argc == 5 ? strtoull(argv[4], nullptr, 0) : 42;
+            generate_csv_log_file(input_name, file_size, seed);
 
             return 0;
-        } else if (argc == 4) {
+        } else if (argc >= 4 && argc <= 7) {
             const string output_name = argv[2];
-            const long total_mem = strtol(argv[3], nullptr, 0); // bytes
+            const size_t total_mem = max(strtol(argv[3], nullptr, 0), 0L); // bytes, 0 if negative
+            // Run generation: "replacement" for replacement selection, or sort threads for pipelined run generation,
+            // 0 reads, sorts and writes one run at a time
+            const string strategy_name = argc >= 5 ? argv[4] : "0";
+            const int sort_threads = static_cast<int>(strtol(strategy_name.c_str(), nullptr, 0));
+            const run_strategy strategy = strategy_name == "replacement" ? run_strategy::replacement_selection
+                                          : sort_threads > 0 ? run_strategy::pipelined : run_strategy::load_sort;
             const ifstream cvs_log_file_stream(input_name.c_str());
             if (!cvs_log_file_stream.good()) {
                 generate_csv_log_file(input_name, total_mem);
             }
-            // sort index for cvs column default to asc
-            const vector<int> sort_array = {2, 1};
-
-            const int runs_count = input_cvs_file(input_name, total_mem, sort_array);
+            // sort index for cvs column default to asc: CustomerId, PageId
+            const sort_key_encoder sort_key = sort_key_encoder::parse(argc >= 6 ? argv[5] : "2,1");
+            // Smaller blocks merge more runs at once, in fewer passes
+            const size_t read_block_size = argc == 7 ? strtoul(argv[6], nullptr, 0) : RUN_READ_BLOCK_SIZE;
+            if (read_block_size == 0) {
+                cout << "read_block_size must be positive" << endl << "Exit program!" << endl;
+                return -1;
+            }
 
-            merge_cvs_files(runs_count, output_name, sort_array);
+            const int runs_count = input_cvs_file(input_name, total_mem, sort_key, strategy, sort_threads);
+            if (runs_count < 0 || !merge_cvs_files(runs_count, output_name, sort_key, total_mem, read_block_size)) {
+                cout << "Exit program!" << endl;
+                return -1;
+            }
 
-            cout << "Entire process took a total of: " << float(clock() - begin_time) / CLOCKS_PER_SEC * 1000
-                 << " milliseconds." << endl;
+            cout << "Entire process took a total of: " << elapsed_milliseconds() << " milliseconds." << endl;
 
             return 0;
         }
     }
 
-    cout << "To generate input file: input_file mem_size" << endl <<
-         "Or to sort extra large file: input_file output_file mem_size" << endl <<
-         "Note: mem_size in bytes such as 1048576 (1MB)" << endl <<
+    cout << "To generate input file: input_file mem_size [--seed seed]" << endl <<
+         "Or to sort extra large file: input_file output_file mem_size [sort_threads | replacement] [sort_order] "
+         "[read_block_size]" << endl <<
+         "Note: sort_order is a list of column indexes with optional :num and :desc such as 2,1 (default) or 0:num:desc"
+         << endl <<
+         "Note: mem_size in bytes such as 1048576 (1MB), it also sets how many runs are merged at once with "
+         "read_block_size (default 524288)" << endl <<
+         "Note: the generated file only depends on mem_size and seed, which is 42 by default and when a missing "
+         "input_file to sort is generated" << endl <<
          "Exit program!" << endl;
     return -1;
 }
@@ -0,0 +1,83 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mapped_log_file.h"
+#include "id_helper.h"
+#include "loyalty_window.h"
+#include "metrics.h"
+
+using namespace std;
+
+/**
+ * Let’s say we have a website and we keep track of what pages customers are viewing, for things like business metrics.
+ *
+ * Every time somebody comes to the website, we write a record to a log file consisting of Timestamp, PageId,
+ * CustomerId. At the end of the day we have a big log file with many entries in that format. And for every day
+ * we have a new file.
+ *
+ * Here the criteria are evaluated every day over a rolling window: ‘loyal customers’ came on at least K of the last N
+ * days and visited at least P distinct pages in those days. Each new day only updates the customers it visits and
+ * the customers of the day leaving the window, the state is never rebuilt from scratch.
+ */
+
+void add_day(loyalty_window &window, page_dictionary &page_ids_dictionary, const string &process_log_file_name) {
+    const metrics::scoped_timer timer("read_day");
+    MappedLogFile process_log_file_reader;
+    process_log_file_reader.open(process_log_file_name);
+    window.begin_day();
+    uuid128 customer_id;
+    size_t malformed_count = 0;
+    for (const auto &record: process_log_file_reader) {
+        if (!id_helper::parse_uuid(record.customer_id, customer_id)) {
+            malformed_count++;
+            continue;
+        }
+        window.visit(customer_id, page_ids_dictionary.intern(record.page_id));
+    }
+    process_log_file_reader.close();
+    id_helper::report_malformed_ids(process_log_file_name, malformed_count);
+}
+
+int main(const int argc, const char *argv[]) {
+    metrics::start("GetLoyalCustomersInWindow");
+    const string path = "../logs";
+    // Default to the original criteria over the three sample days: 2 of 3 days and 2 distinct pages
+    size_t window_days = 3, min_days = 2, min_pages = 2;
+    vector<string> day_log_file_names = {path + "/day1.log", path + "/day2.log", path + "/day3.log"};
+    if (argc >= 5) {
+        window_days = strtoul(argv[1], nullptr, 0);
+        min_days = strtoul(argv[2], nullptr, 0);
+        min_pages = strtoul(argv[3], nullptr, 0);
+        day_log_file_names.assign(argv + 4, argv + argc);
+    } else if (argc != 1) {
+        cout << "To find loyal customers over a rolling window: window_days min_days min_pages day_log_file..."
+             << endl << "Exit program!" << endl;
+        return -1;
+    }
+    if (window_days == 0 || window_days > loyalty_window::MAX_WINDOW_DAYS || min_pages == 0 ||
+        min_pages > loyalty_window::MAX_MIN_PAGES) {
+        cout << "window_days must be from 1 to " << loyalty_window::MAX_WINDOW_DAYS << " and min_pages from 1 to "
+             << loyalty_window::MAX_MIN_PAGES << endl << "Exit program!" << endl;
+        return -1;
+    }
+
+    loyalty_window window(window_days, min_days, min_pages);
+    // Page id strings interned into dense ordinals
+    page_dictionary page_ids_dictionary;
+    for (const auto &day_log_file_name: day_log_file_names) {
+        add_day(window, page_ids_dictionary, day_log_file_name);
+        cout << "Day " << day_log_file_name << ": " << window.size() << " customers in the window, "
+             << window.loyal_customers().size() << " loyal" << endl;
+    }
+
+    const vector<uuid128> loyal_customers = window.loyal_customers();
+    cout << "There are " << loyal_customers.size() << " loyal customers" << endl;
+    for (const auto &customer_id: loyal_customers) cout << id_helper::to_uuid_string(customer_id) << endl;
+
+    return 0;
+}
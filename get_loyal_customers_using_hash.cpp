@@ -0,0 +1,181 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "mapped_log_file.h"
+#include "id_helper.h"
+#include "customer_state_table.h"
+#include "columnar_log_file.h"
+#include "loyalty_checkpoint.h"
+#include "metrics.h"
+
+using namespace std;
+
+/**
+ * Let’s say we have a website and we keep track of what pages customers are viewing, for things like business metrics.
+ *
+ * Every time somebody comes to the website, we write a record to a log file consisting of Timestamp, PageId,
+ * CustomerId. At the end of the day we have a big log file with many entries in that format. And for every day
+ * we have a new file.
+ *
+ * Now, given two log files (log file from day 1 and log file from day 2) we want to generate a list of
+ * ‘loyal customers’ that meet the criteria of: (a) they came on both days, and (b) they visited at least two unique
+ * pages.
+ *
+ * Same result as GetLoyalCustomersUsingSet, but the per customer state is folded into one compact customer_state (the
+ * last day seen with the number of days seen, the first page seen and a two unique pages flag) stored in a flat open
+ * addressing hash table. Every record is one probe into a contiguous array and no memory is allocated per record.
+ *
+ * A day converted by ConvertLogToColumnar (dayN.col next to dayN.log) is read from its columns with no parsing at all.
+ *
+ * With --append-day, only the new day log is read: the state of all the previous days is loaded from a checkpoint
+ * and the updated state is saved back for the next night.
+ */
+
+bool find_loyal_customers(customer_state_table &customers,
+                          page_dictionary &page_ids_dictionary,
+                          const string &process_log_file_name,
+                          const uint32_t day) {
+    const metrics::scoped_timer timer("read_day");
+    MappedLogFile process_log_file_reader;
+    if (!process_log_file_reader.open(process_log_file_name)) return false;
+    uuid128 customer_id;
+    size_t malformed_count = 0;
+    for (const auto &record: process_log_file_reader) {
+        if (!id_helper::parse_uuid(record.customer_id, customer_id)) {
+            malformed_count++;
+            continue;
+        }
+        customer_state &state = customers.find_or_insert(customer_id);
+        // Only the first page matters once two unique pages have been seen
+        state.visit(day, state.two_pages ? state.first_page : page_ids_dictionary.intern(record.page_id));
+    }
+    process_log_file_reader.close();
+    id_helper::report_malformed_ids(process_log_file_name, malformed_count);
+    return true;
+}
+
+bool find_loyal_customers_columnar(customer_state_table &customers,
+                                   page_dictionary &page_ids_dictionary,
+                                   const string &process_log_file_name,
+                                   const uint32_t day) {
+    const metrics::scoped_timer timer("read_day");
+    ColumnarLogFile process_log_file_reader;
+    if (!process_log_file_reader.open(process_log_file_name)) return false;
+    // The file has its own page dictionary: translate its ordinals once per page, not once per record
+    const page_dictionary &file_page_ids = process_log_file_reader.page_ids();
+    vector<page_ordinal> page_ids(file_page_ids.size());
+    for (page_ordinal ordinal = 0; ordinal < page_ids.size(); ordinal++)
+        page_ids[ordinal] = page_ids_dictionary.intern(file_page_ids.page_id(ordinal));
+
+    for (size_t block_index = 0; block_index < process_log_file_reader.blocks_count(); block_index++) {
+        const auto &block = process_log_file_reader.get_block(block_index);
+        for (size_t i = 0; i < block.records_count; i++)
+            customers.find_or_insert(block.customer_ids[i]).visit(day, page_ids[block.page_ids[i]]);
+    }
+    process_log_file_reader.close();
+    return true;
+}
+
+/**
+ * Find loyal customers of one day, from its columnar file when it has been converted and is not damaged
+ * @param customers loyalty state by customer id
+ * @param page_ids_dictionary page id strings interned into dense ordinals
+ * @param day_log_file_name day log file name without extension
+ * @param day day of the log file, from 1
+ * @return false if neither file can be read
+ */
+bool find_loyal_customers_of_day(customer_state_table &customers,
+                                 page_dictionary &page_ids_dictionary,
+                                 const string &day_log_file_name,
+                                 const uint32_t day) {
+    const string columnar_file_name = day_log_file_name + ".col";
+    if (ColumnarLogFile::is_columnar(columnar_file_name)) {
+        if (find_loyal_customers_columnar(customers, page_ids_dictionary, columnar_file_name, day)) return true;
+        cerr << "File " << columnar_file_name << " is damaged, reading " << day_log_file_name << ".log instead" << endl;
+    }
+    return find_loyal_customers(customers, page_ids_dictionary, day_log_file_name + ".log", day);
+}
+
+/**
+ * Print the loyal customers in customer id order
+ * @param customers loyalty state by customer id
+ */
+void print_loyal_customers(const customer_state_table &customers) {
+    vector<uuid128> loyal_customers;
+    for (const auto &state: customers.slots())
+        if (state.is_loyal()) loyal_customers.push_back(state.customer_id);
+    sort(loyal_customers.begin(), loyal_customers.end());
+
+    cout << "There are " << loyal_customers.size() << " loyal customers" << endl;
+    for (const auto &customer_id: loyal_customers) cout << id_helper::to_uuid_string(customer_id) << endl;
+}
+
+/**
+ * Fold one new day into the checkpoint of all the previous days, so the nightly run only reads the new day log
+ * @param day_log_file_name new day log file, in cvs or columnar format
+ * @param checkpoint_file_name checkpoint file, created when it does not exist yet
+ * @return 0 on success
+ */
+int append_day(const string &day_log_file_name, const string &checkpoint_file_name) {
+    customer_state_table customers;
+    page_dictionary page_ids_dictionary;
+    uint32_t last_day = 0;
+    if (filesystem::exists(checkpoint_file_name) &&
+        !LoyaltyCheckpoint::load(checkpoint_file_name, customers, page_ids_dictionary, last_day)) {
+        cout << "File '" << checkpoint_file_name << "' is not a checkpoint!" << endl << "Exit program!" << endl;
+        return -1;
+    }
+
+    // Nothing is saved when the day cannot be read, so the checkpoint still ends at the day before
+    const bool day_read = ColumnarLogFile::is_columnar(day_log_file_name)
+                          ? find_loyal_customers_columnar(customers, page_ids_dictionary, day_log_file_name, ++last_day)
+                          : find_loyal_customers(customers, page_ids_dictionary, day_log_file_name, ++last_day);
+    if (!day_read) {
+        cout << "File '" << day_log_file_name << "' cannot be read!" << endl << "Exit program!" << endl;
+        return -1;
+    }
+
+    if (!LoyaltyCheckpoint::save(checkpoint_file_name, customers, page_ids_dictionary, last_day)) {
+        cout << "File '" << checkpoint_file_name << "' cannot be written!" << endl << "Exit program!" << endl;
+        return -1;
+    }
+    cout << "Day " << last_day << " has been appended to " << checkpoint_file_name << endl;
+    print_loyal_customers(customers);
+    return 0;
+}
+
+int main(const int argc, const char *argv[]) {
+    metrics::start("GetLoyalCustomersUsingHash");
+    const string path = "../logs";
+
+    if (argc >= 2 && string(argv[1]) == "--append-day") {
+        if (argc == 3 || argc == 4)
+            return append_day(argv[2], argc == 4 ? argv[3] : path + "/loyalty.checkpoint");
+        cout << "To append a day: --append-day day_log_file [checkpoint_file]" << endl << "Exit program!" << endl;
+        return -1;
+    }
+
+    // Loyalty state by customer id
+    customer_state_table customers;
+    // Page id strings interned into dense ordinals
+    page_dictionary page_ids_dictionary;
+
+    for (uint32_t day = 1; day <= 3; day++) {
+        const string day_log_file_name = path + "/day" + to_string(day);
+        if (!find_loyal_customers_of_day(customers, page_ids_dictionary, day_log_file_name, day)) {
+            cout << "File '" << day_log_file_name << ".log' is not found!" << endl << "Exit program!" << endl;
+            return -1;
+        }
+    }
+
+    print_loyal_customers(customers);
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "id_helper.h"
+#include "customer_partitions.h"
+#include "metrics.h"
+
+using namespace std;
+
+/**
+ * Let’s say we have a website and we keep track of what pages customers are viewing, for things like business metrics.
+ *
+ * Every time somebody comes to the website, we write a record to a log file consisting of Timestamp, PageId,
+ * CustomerId. At the end of the day we have a big log file with many entries in that format. And for every day
+ * we have a new file.
+ *
+ * Now, given two log files (log file from day 1 and log file from day 2) we want to generate a list of
+ * ‘loyal customers’ that meet the criteria of: (a) they came on both days, and (b) they visited at least two unique
+ * pages.
+ *
+ * GetLoyalCustomersUsingSet needs every customer in memory and GetLoyalCustomersUsingSortedFile needs every day sorted
+ * first. Here the days are joined with a grace hash join instead: all the visits are scattered by customer id into
+ * partition files, then every partition is loaded alone into a hash table. Memory is bounded by mem_size like
+ * ExternalSortingCSV, and every day log is read once and every partition written and read once.
+ */
+
+int main(const int argc, const char *argv[]) {
+    metrics::start("GetLoyalCustomersUsingPartitions");
+    const string path = "../logs";
+    // Memory for one partition's loyalty state, in bytes
+    const uint64_t mem_size = argc > 1 ? strtoull(argv[1], nullptr, 0) : 64 * 1024 * 1024;
+    vector<string> day_log_file_names = {path + "/day1.log", path + "/day2.log", path + "/day3.log"};
+    if (argc > 2) day_log_file_names.assign(argv + 2, argv + argc);
+    if (mem_size == 0) {
+        cout << "To find loyal customers with a memory budget: [mem_size [day_log_file...]]" << endl
+             << "Note: mem_size in bytes such as 1048576 (1MB)" << endl << "Exit program!" << endl;
+        return -1;
+    }
+
+    uint64_t input_bytes = 0;
+    for (const auto &day_log_file_name: day_log_file_names) {
+        if (!filesystem::exists(day_log_file_name)) {
+            cout << "File '" << day_log_file_name << "' is not found!" << endl << "Exit program!" << endl;
+            return -1;
+        }
+        input_bytes += filesystem::file_size(day_log_file_name);
+    }
+
+    customer_partitions partitions(mem_size);
+    if (!partitions.open(customer_partitions::partitions_for(input_bytes, mem_size))) {
+        cout << "Exit program!" << endl;
+        return -1;
+    }
+    cout << "Scattering " << input_bytes << " bytes of day logs into " << partitions.size() << " partitions" << endl;
+    // Page id strings interned into dense ordinals, shared by all the partitions
+    page_dictionary page_ids_dictionary;
+    uint32_t day = 0;
+    for (const auto &day_log_file_name: day_log_file_names)
+        partitions.add_log_file(day_log_file_name, ++day, page_ids_dictionary);
+
+    vector<uuid128> loyal_customers;
+    if (!partitions.loyal_customers(page_ids_dictionary, loyal_customers)) {
+        cout << "Exit program!" << endl;
+        return -1;
+    }
+    cout << "There are " << loyal_customers.size() << " loyal customers" << endl;
+    for (const auto &customer_id: loyal_customers) cout << id_helper::to_uuid_string(customer_id) << endl;
+
+    return 0;
+}
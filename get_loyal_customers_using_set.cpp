@@ -3,12 +3,17 @@
 //
 
 #include <iostream>
-#include <fstream>
 #include <string>
 #include "map"
 #include "set"
 
-#include "string_helper.h"
+#include "log_record.h"
+#include "mapped_log_file.h"
+#include "id_helper.h"
+#include "sharded_customer_states.h"
+#include "distinct_page_sketch.h"
+#include "customer_filter.h"
+#include "metrics.h"
 
 using namespace std;
 
@@ -32,31 +37,66 @@ using namespace std;
  * map: Maps are associative containers that store elements formed by a combination of a key value and a mapped value,
  * following a specific order.
  * https://cplusplus.com/reference/map/map/
+ *
+ * With --approximate, the criteria are generalized to at least P unique pages and the set of page ids of a customer
+ * is replaced by a distinct_page_sketch: exact up to a few pages, then a HyperLogLog with a configurable error, so a
+ * heavy user or a bot takes no more memory than anybody else.
+ *
+ * With --prefilter, a first pass builds a Bloom filter of the customers of every day. A record is then only folded
+ * into the map when its customer may have come on another day, so the one time visitors of a day never get an entry.
+ * With --prefilter threads_count, the sharded workers skip those visits before scattering them.
  */
 
-// Result for loyal customers
-set<string> loyal_customers;
+// Result for loyal customers, customer ids are turned back into UUID strings only for output
+set<uuid128> loyal_customers;
+
+/**
+ * Build the filter of the customers that came on a day
+ * @param process_log_file_name day log file name
+ * @return filter of the customer ids of the day
+ */
+customer_filter build_customer_filter(const string &process_log_file_name) {
+    const metrics::scoped_timer timer("build_filter");
+    MappedLogFile process_log_file_reader;
+    process_log_file_reader.open(process_log_file_name);
+    // Records are an upper bound of the customers, no need to count them first
+    customer_filter customers(process_log_file_reader.size() / log_record::MIN_RECORD_SIZE);
+    uuid128 customer_id;
+    for (const auto &record: process_log_file_reader)
+        if (id_helper::parse_uuid(record.customer_id, customer_id))
+            customers.insert(customer_id);
+    process_log_file_reader.close();
+    return customers;
+}
 
-void find_loyal_customers(map<string, map<int, set<string>>> &pages_visited_by_customer,
+void find_loyal_customers(map<uuid128, map<int, set<page_ordinal>>> &pages_visited_by_customer,
+                          page_dictionary &page_ids_dictionary,
                           const string &process_log_file_name,
-                          const int day) {
-    ifstream process_log_file_reader;
+                          const int day,
+                          const vector<customer_filter> &customers_by_day = {}) {
+    const metrics::scoped_timer timer("read_day");
+    MappedLogFile process_log_file_reader;
     process_log_file_reader.open(process_log_file_name);
-    string line;
-    while (getline(process_log_file_reader, line)) {
-        const vector<string> data = string_helper::split(line, ",");
-        const auto page_id = data[1];       // NOLINT(*-unnecessary-copy-initialization)
-        const auto customer_id = data[2];   // NOLINT(*-unnecessary-copy-initialization)
+    uuid128 customer_id;
+    size_t malformed_count = 0;
+    for (const auto &record: process_log_file_reader) {
+        if (!id_helper::parse_uuid(record.customer_id, customer_id)) {
+            malformed_count++;
+            continue;
+        }
         if (loyal_customers.count(customer_id))
             continue;
-        map<int, set<string>> page_ids_by_day;
+        if (!customer_filter::may_come_on_another_day(customers_by_day, customer_id, day))
+            continue;
+        const page_ordinal page_id = page_ids_dictionary.intern(record.page_id);
+        map<int, set<page_ordinal>> page_ids_by_day;
         if (pages_visited_by_customer.count(customer_id)) {
             page_ids_by_day = pages_visited_by_customer.at(customer_id);
 
             for (auto each_day = page_ids_by_day.begin(); each_day != page_ids_by_day.end(); each_day++) {
                 if (each_day->first == day) {
                     // Same day: store the page id visited
-                    set<string> page_ids = each_day->second;
+                    set<page_ordinal> page_ids = each_day->second;
                     page_ids.insert(page_id);
                 } else {
                     // Two different days
@@ -73,26 +113,123 @@ void find_loyal_customers(map<string, map<int, set<string>>> &pages_visited_by_c
                 }
             }
         } else {
-            set<string> page_ids;
+            set<page_ordinal> page_ids;
             page_ids.insert(page_id);
             page_ids_by_day.insert({day, page_ids});
             pages_visited_by_customer.insert({customer_id, page_ids_by_day});
         }
     }
     process_log_file_reader.close();
+    id_helper::report_malformed_ids(process_log_file_name, malformed_count);
 }
 
-int main() {
+/**
+ * Approximate loyalty state of one customer: the days it came on and a sketch of its distinct pages
+ */
+struct approximate_customer_state {
+    explicit approximate_customer_state(const uint8_t precision) : page_ids(precision) {}
+
+    int last_day = 0;
+    int days_count = 0;
+    distinct_page_sketch page_ids;
+};
+
+void find_loyal_customers_approximately(map<uuid128, approximate_customer_state> &customer_states,
+                                        const string &process_log_file_name,
+                                        const int day,
+                                        const double min_pages,
+                                        const uint8_t precision) {
+    const metrics::scoped_timer timer("read_day");
+    MappedLogFile process_log_file_reader;
+    process_log_file_reader.open(process_log_file_name);
+    uuid128 customer_id;
+    size_t malformed_count = 0;
+    for (const auto &record: process_log_file_reader) {
+        if (!id_helper::parse_uuid(record.customer_id, customer_id)) {
+            malformed_count++;
+            continue;
+        }
+        if (loyal_customers.count(customer_id))
+            continue;
+        auto &state = customer_states.try_emplace(customer_id, precision).first->second;
+        bool changed = state.page_ids.add(record.page_id);
+        if (state.last_day != day) {
+            state.last_day = day;
+            state.days_count++;
+            changed = true;
+        }
+        if (changed && state.days_count >= 2 && state.page_ids.estimate() >= min_pages) {
+            // Add into loyal customers and remove from processing customer list
+            loyal_customers.insert(customer_id);
+            customer_states.erase(customer_id);
+        }
+    }
+    process_log_file_reader.close();
+    id_helper::report_malformed_ids(process_log_file_name, malformed_count);
+}
+
+int main(const int argc, const char *argv[]) {
+    metrics::start("GetLoyalCustomersUsingSet");
     const string path = "../logs";
-    // Store pages visited by customer: the key is customer id and the value is set of page ids by day
-    map<string, map<int, set<string>>> pages_visited_by_customer;
 
-    find_loyal_customers(pages_visited_by_customer, path + "/day1.log", 1);
-    find_loyal_customers(pages_visited_by_customer, path + "/day2.log", 2);
-    find_loyal_customers(pages_visited_by_customer, path + "/day3.log", 3);
+    if (argc >= 2 && string(argv[1]) == "--approximate") {
+        if (argc != 3 && argc != 4) {
+            cout << "To count unique pages approximately: --approximate min_pages [relative_error]" << endl
+                 << "Exit program!" << endl;
+            return -1;
+        }
+        const double min_pages = strtod(argv[2], nullptr);
+        const uint8_t precision = distinct_page_sketch::precision_for_error(argc == 4 ? strtod(argv[3], nullptr) : 0.05);
+        cout << "Counting unique pages with a relative error of " << distinct_page_sketch::relative_error(precision)
+             << ", at most " << (1 << precision) << " bytes per customer" << endl;
+
+        // Store loyalty state by customer id, with a fixed size sketch of the pages visited
+        map<uuid128, approximate_customer_state> customer_states;
+
+        find_loyal_customers_approximately(customer_states, path + "/day1.log", 1, min_pages, precision);
+        find_loyal_customers_approximately(customer_states, path + "/day2.log", 2, min_pages, precision);
+        find_loyal_customers_approximately(customer_states, path + "/day3.log", 3, min_pages, precision);
+
+        cout << "There are " << loyal_customers.size() << " loyal customers" << endl;
+        for (const auto &customer_id: loyal_customers) cout << id_helper::to_uuid_string(customer_id) << endl;
+        return 0;
+    }
+
+    const bool prefilter = argc >= 2 && string(argv[1]) == "--prefilter";
+    // Optional number of worker threads, after --prefilter if any, more than one switches to the sharded parallel mode
+    const int threads_argument = prefilter ? 2 : 1;
+    const long threads_count = argc > threads_argument ? strtol(argv[threads_argument], nullptr, 0) : 1;
+
+    // Customers of every day, only built with --prefilter
+    vector<customer_filter> customers_by_day;
+    if (prefilter) {
+        customers_by_day.push_back(build_customer_filter(path + "/day1.log"));
+        customers_by_day.push_back(build_customer_filter(path + "/day2.log"));
+        customers_by_day.push_back(build_customer_filter(path + "/day3.log"));
+    }
+
+    if (threads_count > 1) {
+        // Store loyalty state by customer id, partitioned into one shard per thread
+        sharded_customer_states customers(threads_count);
+
+        customers.add_log_file(path + "/day1.log", 1, customers_by_day);
+        customers.add_log_file(path + "/day2.log", 2, customers_by_day);
+        customers.add_log_file(path + "/day3.log", 3, customers_by_day);
+
+        customers.collect_loyal_customers(loyal_customers);
+    } else {
+        // Store pages visited by customer: the key is customer id and the value is set of page ids by day
+        map<uuid128, map<int, set<page_ordinal>>> pages_visited_by_customer;
+        // Page id strings interned into dense ordinals
+        page_dictionary page_ids_dictionary;
+
+        find_loyal_customers(pages_visited_by_customer, page_ids_dictionary, path + "/day1.log", 1, customers_by_day);
+        find_loyal_customers(pages_visited_by_customer, page_ids_dictionary, path + "/day2.log", 2, customers_by_day);
+        find_loyal_customers(pages_visited_by_customer, page_ids_dictionary, path + "/day3.log", 3, customers_by_day);
+    }
 
     cout << "There are " << loyal_customers.size() << " loyal customers" << endl;
-    for (const auto &customer_id: loyal_customers) cout << customer_id << endl;
+    for (const auto &customer_id: loyal_customers) cout << id_helper::to_uuid_string(customer_id) << endl;
 
     return 0;
 }
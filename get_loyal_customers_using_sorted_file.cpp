@@ -5,11 +5,18 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <algorithm>
 #include "map"
 #include "set"
 
 #include "string_helper.h"
 #include "cvs_helper.h"
+#include "log_record.h"
+#include "mapped_log_file.h"
+#include "sort_key.h"
+#include "record_arena.h"
+#include "loser_tree.h"
+#include "metrics.h"
 
 using namespace std;
 
@@ -31,134 +38,82 @@ using namespace std;
  * https://cplusplus.com/reference/set/set/
  */
 
-// Result for loyal customers
-set<string> loyal_customers;
+// Result for loyal customers. less<> lets the string_view fields of a log_record look up without a copy
+set<string, less<>> loyal_customers;
 
 void sort_log_file(const string &file_name, const vector<int> &sort_array) {
-    vector<vector<string>> lines = cvs_helper::read_cvs(file_name);
-    sort(lines.begin(), lines.end(),
-         [sort_array](const vector<string> &row1, const vector<string> &row2) {
-             for (auto &sort_column: sort_array) {
-                 if (sort_column >= 0 && sort_column < row1.size() && sort_column < row2.size() &&
-                     row1.at(sort_column) != row2.at(sort_column))
-                     return row1.at(sort_column) < row2.at(sort_column);
-             }
-             return false;
-         });
+    const metrics::scoped_timer timer("sort_day");
+    // Lines next to the normalized keys of their sort columns in one arena, radix sorted byte by byte
+    const sort_key_encoder sort_key(sort_array);
+    record_arena lines;
+    cvs_helper::read_cvs(file_name, sort_key, lines);
+    lines.sort();
     const string sorted_file_name
             = string_helper::get_new_file_name(file_name, "_sorted");
     cvs_helper::write_cvs(sorted_file_name, lines);
 }
 
-void find_loyal_customers(const string &day0_log_file_name, const string &process_log_file_name) {
-    const ifstream day0_log_file_exists(day0_log_file_name.c_str());
-    if (day0_log_file_exists.good()) {
-        const string temp_log_file_name
-                = string_helper::get_new_file_name(process_log_file_name, "_temp");
-        // Remove file
-        filesystem::remove(temp_log_file_name.c_str());
-        ofstream temp_log_file_writer;
-        temp_log_file_writer.open(temp_log_file_name);
-
-        ifstream day_log_file_reader;
-        day_log_file_reader.open(process_log_file_name);
-        string day_log_file_line;
-        getline(day_log_file_reader, day_log_file_line);
-
-        ifstream day0_log_file_reader;
-        day0_log_file_reader.open(day0_log_file_name);
-        string day0_log_file_line;
-        getline(day0_log_file_reader, day0_log_file_line);
-
-        while (!day_log_file_reader.eof() && !day0_log_file_reader.eof()) {
-            const vector<string> day_log_data = string_helper::split(day_log_file_line, ",");
-            const auto &page_id = day_log_data[1];
-            const auto &customer_id = day_log_data[2];
-            if (loyal_customers.count(customer_id)) {
-                getline(day_log_file_reader, day_log_file_line);
-                continue;
-            }
-            while (!day0_log_file_reader.eof()) {
-                const vector<string> day0_log_data = string_helper::split(day0_log_file_line, ",");
-                const auto &page_id0 = day0_log_data[1];
-                const auto &customer_id0 = day0_log_data[2];
-                if (loyal_customers.count(customer_id0)) {
-                    getline(day0_log_file_reader, day0_log_file_line);
-                    continue;
-                }
-                if (strcmp(customer_id0.c_str(), customer_id.c_str()) > 0) {
-                    // Reserve for next day 0 log
-                    temp_log_file_writer << string_helper::join(day_log_data, ",") << endl;
-                    getline(day_log_file_reader, day_log_file_line);
-                    break;
-                } else if (strcmp(customer_id0.c_str(), customer_id.c_str()) < 0) {
-                    // Reserve for next day 0 log
-                    temp_log_file_writer << string_helper::join(day0_log_data, ",") << endl;
-                    getline(day0_log_file_reader, day0_log_file_line);
-                } else {
-                    // Same customer in different to days
-                    if (page_id0 != page_id) {
-                        // Match two unique pages
-                        loyal_customers.insert(customer_id);
-
-                        getline(day0_log_file_reader, day0_log_file_line);
-                        while (!day0_log_file_reader.eof()) {
-                            const vector<string> pre_day0_log_data
-                                    = string_helper::split(day0_log_file_line, ",");
-                            const auto &pre_customer_id0 = pre_day0_log_data[2];
-                            if (pre_customer_id0 != customer_id)
-                                break;
-                            getline(day0_log_file_reader, day0_log_file_line);
-                        }
-
-                        getline(day_log_file_reader, day_log_file_line);
-                        while (!day_log_file_reader.eof()) {
-                            const vector<string> pre_day_log_data
-                                    = string_helper::split(day_log_file_line, ",");
-                            const auto &pre_customer_id = pre_day_log_data[2];
-                            if (pre_customer_id != customer_id)
-                                break;
-                            getline(day_log_file_reader, day_log_file_line);
-                        }
-                    } else {
-                        // Same page id for between two days
-                        getline(day0_log_file_reader, day0_log_file_line);
-                        if (!day0_log_file_reader.eof()) {
-                            const vector<string> pre_day0_log_data
-                                    = string_helper::split(day0_log_file_line, ",");
-                            const auto &pre_customer_Id0 = pre_day0_log_data[2];
-                            if (pre_customer_Id0 == customer_id) continue;
-                        }
-
-                        getline(day_log_file_reader, day_log_file_line);
-                    }
-                    break;
-                }
-            }
-        }
+/**
+ * Merge all the sorted day log files at once, grouped by customer id, and keep the customers that came on at least
+ * two days and visited at least two unique pages. Only the current record of every day is held in memory and no
+ * intermediate file is written.
+ * @param sorted_log_file_names day log files sorted by customer id then page id
+ */
+void find_loyal_customers(const vector<string> &sorted_log_file_names) {
+    const metrics::scoped_timer timer("merge_days");
+    const size_t days_count = sorted_log_file_names.size();
+    vector<MappedLogFile> day_log_file_readers(days_count);
+    vector<MappedLogFile::iterator> day_log_data, day_log_end;
+    for (size_t day = 0; day < days_count; day++) {
+        day_log_file_readers[day].open(sorted_log_file_names[day]);
+        day_log_data.push_back(day_log_file_readers[day].begin());
+        day_log_end.push_back(day_log_file_readers[day].end());
+    }
 
-        while (!day_log_file_reader.eof()) {
-            temp_log_file_writer << day_log_file_line << endl;
-            getline(day_log_file_reader, day_log_file_line);
-        }
-        day_log_file_reader.close();
-        while (!day0_log_file_reader.eof()) {
-            temp_log_file_writer << day0_log_file_line << endl;
-            getline(day0_log_file_reader, day0_log_file_line);
+    // Exhausted days rank last, ties go to the earlier day so a customer's records come day by day
+    auto less = [&day_log_data, &day_log_end](const size_t a, const size_t b) {
+        if (day_log_data[b] == day_log_end[b]) return day_log_data[a] != day_log_end[a];
+        if (day_log_data[a] == day_log_end[a]) return false;
+        const int compare = day_log_data[a]->customer_id.compare(day_log_data[b]->customer_id);
+        return compare < 0 || (compare == 0 && a < b);
+    };
+    loser_tree<decltype(less)> merge_tree(days_count, less);
+    merge_tree.build();
+
+    // State of the current customer group. Views stay valid while the files are mapped
+    string_view customer_id, first_page_id;
+    size_t last_day = 0, days = 0;
+    bool two_pages = false;
+    while (days_count > 0) {
+        const size_t day = merge_tree.winner();
+        const bool exhausted = day_log_data[day] == day_log_end[day];
+        if (exhausted || day_log_data[day]->customer_id != customer_id) {
+            // The previous customer group is complete
+            if (days >= 2 && two_pages) loyal_customers.emplace_hint(loyal_customers.end(), customer_id);
+            if (exhausted) break;
+            customer_id = day_log_data[day]->customer_id;
+            first_page_id = day_log_data[day]->page_id;
+            last_day = day;
+            days = 1;
+            two_pages = false;
+        } else {
+            if (day != last_day) {
+                last_day = day;
+                days++;
+            }
+            if (!two_pages && day_log_data[day]->page_id != first_page_id) two_pages = true;
         }
-        day0_log_file_reader.close();
-
-        // For next day 0 log file
-        temp_log_file_writer.close();
-        filesystem::copy(temp_log_file_name, day0_log_file_name);
-        // Remove file
-        filesystem::remove(temp_log_file_name.c_str());
-    } else {
-        filesystem::copy(process_log_file_name, day0_log_file_name);
+        ++day_log_data[day];
+        merge_tree.replay();
     }
+
+    for (auto &day_log_file_reader: day_log_file_readers) day_log_file_reader.close();
+    metrics::add(metric::merge_passes);
+    metrics::add(metric::heap_comparisons, merge_tree.comparisons_count());
 }
 
 int main() {
+    metrics::start("GetLoyalCustomersUsingSortedFile");
     const string path = "../logs";
 
     // sort index for cvs column default to asc
@@ -168,16 +123,7 @@ int main() {
     sort_log_file(path + "/day2.log", sort_array);
     sort_log_file(path + "/day3.log", sort_array);
 
-    const string day0_log_file_name = path + "/day0_sorted.log";
-    // Remove file
-    filesystem::remove(day0_log_file_name.c_str());
-
-    find_loyal_customers(day0_log_file_name, path + "/day1_sorted.log");
-    find_loyal_customers(day0_log_file_name, path + "/day2_sorted.log");
-    find_loyal_customers(day0_log_file_name, path + "/day3_sorted.log");
-
-    // Clean up: remove file
-    filesystem::remove(day0_log_file_name.c_str());
+    find_loyal_customers({path + "/day1_sorted.log", path + "/day2_sorted.log", path + "/day3_sorted.log"});
 
     cout << "There are " << loyal_customers.size() << " loyal customers" << endl;
     for (const auto &customer_id: loyal_customers) cout << customer_id << endl;
@@ -0,0 +1,27 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_HASH_HELPER_H
+#define TEST_HASH_HELPER_H
+
+#include <cstdint>
+
+using namespace std;
+
+class hash_helper {
+public:
+    /**
+     * Mix a 64-bit value into a well spread hash, a bijection so distinct values keep distinct hashes
+     * @param x value to mix
+     * @return mixed value
+     */
+    static uint64_t mix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+};
+
+#endif //TEST_HASH_HELPER_H
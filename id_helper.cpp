@@ -0,0 +1,199 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <cstring>
+#include <iostream>
+
+#include "id_helper.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// SSE2 is part of x86-64, so the vectorized parse needs no runtime check
+#define ID_HELPER_SSE2
+
+#include <emmintrin.h>
+
+#endif
+
+static const size_t UUID_LENGTH = 36;
+
+#ifdef ID_HELPER_SSE2
+
+/**
+ * Convert 16 hex digits into their values
+ * @param digits 16 hex digit characters
+ * @param values output values from 0 to 15, one per byte
+ * @return true if all of digits are hex digits
+ */
+static bool hex_values(const __m128i digits, __m128i &values) {
+    // Signed compares: bytes from 0x80 are negative so they fail both ranges
+    const __m128i is_decimal = _mm_and_si128(_mm_cmpgt_epi8(digits, _mm_set1_epi8('0' - 1)),
+                                             _mm_cmplt_epi8(digits, _mm_set1_epi8('9' + 1)));
+    const __m128i lower_case = _mm_or_si128(digits, _mm_set1_epi8(0x20));
+    const __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(lower_case, _mm_set1_epi8('a' - 1)),
+                                            _mm_cmplt_epi8(lower_case, _mm_set1_epi8('f' + 1)));
+    values = _mm_or_si128(_mm_and_si128(is_decimal, _mm_sub_epi8(digits, _mm_set1_epi8('0'))),
+                          _mm_andnot_si128(is_decimal, _mm_sub_epi8(lower_case, _mm_set1_epi8('a' - 10))));
+    return _mm_movemask_epi8(_mm_or_si128(is_decimal, is_letter)) == 0xFFFF;
+}
+
+/**
+ * Pack the values of 16 hex digits into 8 bytes, two digits per byte with the first one in the high nibble
+ * @param values digit values, one per byte
+ * @return 16-bit lanes holding the packed bytes
+ */
+static __m128i pack_nibbles(const __m128i values) {
+    // Little endian 16-bit lanes hold the first digit in their low byte and the second one in their high byte
+    return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4),
+                        _mm_srli_epi16(values, 8));
+}
+
+/**
+ * Parse a UUID string in 8-4-4-4-12 hex layout into a 128-bit id
+ * @param s UUID string, upper or lower case hex digits
+ * @param id output 128-bit id
+ * @return true if s is a well formed UUID
+ */
+bool id_helper::parse_uuid(const string_view s, uuid128 &id) {
+    if (s.size() != UUID_LENGTH || s[8] != '-' || s[13] != '-' || s[18] != '-' || s[23] != '-') return false;
+    // Gather the 32 hex digits without the hyphens
+    char digits[32];
+    memcpy(digits, s.data(), 8);
+    memcpy(digits + 8, s.data() + 9, 4);
+    memcpy(digits + 12, s.data() + 14, 4);
+    memcpy(digits + 16, s.data() + 19, 4);
+    memcpy(digits + 20, s.data() + 24, 12);
+    __m128i high_values, low_values;
+    if (!hex_values(_mm_loadu_si128(reinterpret_cast<const __m128i *>(digits)), high_values) ||
+        !hex_values(_mm_loadu_si128(reinterpret_cast<const __m128i *>(digits + 16)), low_values))
+        return false;
+    uint64_t halves[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(halves),
+                     _mm_packus_epi16(pack_nibbles(high_values), pack_nibbles(low_values)));
+    // The bytes are in string order, the first one is the most significant
+    id.high = __builtin_bswap64(halves[0]);
+    id.low = __builtin_bswap64(halves[1]);
+    return true;
+}
+
+#else
+
+/**
+ * Get the value of a hex digit
+ * @param c hex digit
+ * @return value of c from 0 to 15, or -1 if c is not a hex digit
+ */
+static int hex_value(const char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Parse a UUID string in 8-4-4-4-12 hex layout into a 128-bit id
+ * @param s UUID string, upper or lower case hex digits
+ * @param id output 128-bit id
+ * @return true if s is a well formed UUID
+ */
+bool id_helper::parse_uuid(const string_view s, uuid128 &id) {
+    if (s.size() != UUID_LENGTH) return false;
+    uint64_t halves[2] = {0, 0};
+    int digits = 0;
+    for (size_t i = 0; i < UUID_LENGTH; i++) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (s[i] != '-') return false;
+            continue;
+        }
+        const int value = hex_value(s[i]);
+        if (value < 0) return false;
+        uint64_t &half = halves[digits++ / 16];
+        half = half << 4 | value;
+    }
+    id.high = halves[0];
+    id.low = halves[1];
+    return true;
+}
+
+#endif
+
+/**
+ * Print a warning for the records of a log file skipped because of a malformed customer id
+ * @param file_name log file name
+ * @param malformed_count number of records skipped, nothing is printed when 0
+ */
+void id_helper::report_malformed_ids(const string &file_name, const size_t malformed_count) {
+    if (malformed_count > 0)
+        cerr << "Skipped " << malformed_count << " records of " << file_name << " with a malformed customer id"
+             << endl;
+}
+
+/**
+ * Format a 128-bit id as a lower case UUID string
+ * @param id 128-bit id
+ * @return UUID string in 8-4-4-4-12 hex layout
+ */
+string id_helper::to_uuid_string(const uuid128 &id) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    string result(UUID_LENGTH, '-');
+    int digits = 0;
+    for (size_t i = 0; i < UUID_LENGTH; i++) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) continue;
+        const uint64_t half = digits < 16 ? id.high : id.low;
+        result[i] = HEX_DIGITS[half >> (60 - 4 * (digits++ % 16)) & 0xF];
+    }
+    return result;
+}
+
+/**
+ * Get the ordinal of a page id, adding it to the dictionary if it is new
+ * @param page_id page id string
+ * @return ordinal of page_id
+ */
+page_ordinal page_dictionary::intern(const string_view page_id) {
+    const auto found = ordinals.find(page_id);
+    if (found != ordinals.end()) return found->second;
+    const auto ordinal = static_cast<page_ordinal>(page_ids.size());
+    ordinals.emplace(page_ids.emplace_back(page_id), ordinal);
+    page_ids_bytes += page_id.size();
+    return ordinal;
+}
+
+size_t page_dictionary::memory_size() const {
+    // Every page id is a string in the deque and a node of the map, next to the buckets of the map
+    const size_t entry_size = sizeof(string) + sizeof(pair<const string_view, page_ordinal>) + 2 * sizeof(void *);
+    return page_ids.size() * entry_size + page_ids_bytes + ordinals.bucket_count() * sizeof(void *);
+}
+
+void page_dictionary::write(ostream &output) const {
+    for (const auto &page_id: page_ids) {
+        const auto length = static_cast<uint16_t>(page_id.size());
+        output.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        output.write(page_id.data(), length);
+    }
+}
+
+bool page_dictionary::read(istream &input, const uint32_t count) {
+    string page_id;
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t length;
+        if (!input.read(reinterpret_cast<char *>(&length), sizeof(length))) return false;
+        page_id.resize(length);
+        if (!input.read(page_id.data(), length)) return false;
+        intern(page_id);
+    }
+    return true;
+}
+
+bool page_dictionary::read(string_view &data, const uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t length;
+        if (data.size() < sizeof(length)) return false;
+        memcpy(&length, data.data(), sizeof(length));
+        data.remove_prefix(sizeof(length));
+        if (data.size() < length) return false;
+        intern(data.substr(0, length));
+        data.remove_prefix(length);
+    }
+    return true;
+}
@@ -0,0 +1,125 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_ID_HELPER_H
+#define TEST_ID_HELPER_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+ * Customer id as a 128-bit integer parsed from its 36-char UUID string. Ordering matches the lower case UUID string
+ * ordering, so sorted output stays the same as with string keys.
+ */
+struct uuid128 {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool operator==(const uuid128 &rhs) const { return high == rhs.high && low == rhs.low; }
+
+    bool operator!=(const uuid128 &rhs) const { return !(*this == rhs); }
+
+    bool operator<(const uuid128 &rhs) const { return high != rhs.high ? high < rhs.high : low < rhs.low; }
+};
+
+struct uuid128_hash {
+    size_t operator()(const uuid128 &id) const {
+        // Fold both halves with a multiplicative mix, then bring the high bits down for power of two tables
+        const uint64_t h = (id.high ^ (id.low * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+        return static_cast<size_t>(h ^ (h >> 31));
+    }
+};
+
+/**
+ * Page id interned into a dense ordinal by page_dictionary
+ */
+using page_ordinal = uint32_t;
+
+class id_helper {
+public:
+    /**
+     * Parse a UUID string in 8-4-4-4-12 hex layout into a 128-bit id, 16 digits at a time with SSE2 on x86-64
+     * @param s UUID string, upper or lower case hex digits
+     * @param id output 128-bit id
+     * @return true if s is a well formed UUID
+     */
+    static bool parse_uuid(string_view s, uuid128 &id);
+
+    /**
+     * Format a 128-bit id as a lower case UUID string
+     * @param id 128-bit id
+     * @return UUID string in 8-4-4-4-12 hex layout
+     */
+    static string to_uuid_string(const uuid128 &id);
+
+    /**
+     * Print a warning for the records of a log file skipped because of a malformed customer id
+     * @param file_name log file name
+     * @param malformed_count number of records skipped, nothing is printed when 0
+     */
+    static void report_malformed_ids(const string &file_name, size_t malformed_count);
+};
+
+/**
+ * Interns page id strings into dense 32-bit ordinals, in order of first appearance.
+ */
+class page_dictionary {
+public:
+    /**
+     * Get the ordinal of a page id, adding it to the dictionary if it is new
+     * @param page_id page id string
+     * @return ordinal of page_id
+     */
+    page_ordinal intern(string_view page_id);
+
+    /**
+     * Get the page id string of an ordinal
+     * @param ordinal ordinal returned by intern
+     * @return page id string, valid as long as the dictionary is
+     */
+    string_view page_id(page_ordinal ordinal) const { return page_ids[ordinal]; }
+
+    size_t size() const { return page_ids.size(); }
+
+    /**
+     * @return estimate of the memory held by the dictionary in bytes
+     */
+    size_t memory_size() const;
+
+    /**
+     * Write all the page ids in ordinal order, every one as its uint16 length then its bytes
+     * @param output binary output stream
+     */
+    void write(ostream &output) const;
+
+    /**
+     * Read page ids written by write, interned in file order so they get back the ordinals they were written with
+     * @param input binary input stream
+     * @param count number of page ids to read
+     * @return false if the input ends first
+     */
+    bool read(istream &input, uint32_t count);
+
+    /**
+     * Read page ids written by write from memory, such as a mapped file
+     * @param data bytes to read from, the page ids read are removed from its front
+     * @param count number of page ids to read
+     * @return false if data ends first
+     */
+    bool read(string_view &data, uint32_t count);
+
+private:
+    // deque never moves its elements, so the views used as keys stay valid
+    deque<string> page_ids;
+    unordered_map<string_view, page_ordinal> ordinals;
+    size_t page_ids_bytes = 0;
+};
+
+#endif //TEST_ID_HELPER_H
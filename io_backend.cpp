@@ -0,0 +1,239 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+
+#include "io_backend.h"
+#include "blocking_queue.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define IO_BACKEND_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#endif
+
+// Worker threads of the thread pool backend, enough to keep a disk queue busy
+static const size_t IO_THREADS_COUNT = 4;
+// Submission queue entries of an io_uring, the completion queue is twice as large
+static const unsigned URING_ENTRIES = 256;
+// Opcodes asked about when probing an io_uring
+static const unsigned URING_PROBE_OPS = 256;
+
+/**
+ * Run a request synchronously
+ * @param request request to run
+ * @return bytes transferred, or -errno
+ */
+static long run_request(const io_request &request) {
+    const ssize_t result = request.write
+                           ? pwrite(request.fd, request.buffer, request.length, static_cast<off_t>(request.offset))
+                           : pread(request.fd, request.buffer, request.length, static_cast<off_t>(request.offset));
+    return result < 0 ? -errno : result;
+}
+
+/**
+ * Portable backend: a pool of threads running the requests with pread and pwrite
+ */
+class thread_io_backend : public io_backend {
+public:
+    thread_io_backend() {
+        for (size_t i = 0; i < IO_THREADS_COUNT; i++)
+            workers.emplace_back([this]() {
+                io_request *request;
+                while (pending.pop(request)) {
+                    const long result = run_request(*request);
+                    lock_guard<mutex> lock(done_mutex);
+                    request->result = result;
+                    request->done = true;
+                    completed.notify_all();
+                }
+            });
+    }
+
+    ~thread_io_backend() override {
+        pending.close();
+        for (auto &worker: workers) worker.join();
+    }
+
+    void submit(io_request &request) override {
+        {
+            lock_guard<mutex> lock(done_mutex);
+            request.done = false;
+        }
+        pending.push(&request);
+    }
+
+    void wait(io_request &request) override {
+        unique_lock<mutex> lock(done_mutex);
+        completed.wait(lock, [&request]() { return request.done; });
+    }
+
+    const char *name() const override { return "threads"; }
+
+private:
+    blocking_queue<io_request *> pending;
+    vector<thread> workers;
+    mutex done_mutex;
+    condition_variable completed;
+};
+
+#ifdef IO_BACKEND_URING
+
+/**
+ * Linux backend: an io_uring driven through its system calls, requests are tagged with their own address
+ */
+class uring_io_backend : public io_backend {
+public:
+    ~uring_io_backend() override {
+        if (sqes) munmap(sqes, sqes_size);
+        if (cq_ring && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+        if (sq_ring) munmap(sq_ring, sq_ring_size);
+        if (ring_fd >= 0) close(ring_fd);
+    }
+
+    /**
+     * Set up the ring
+     * @return false if io_uring is not available, such as on old kernels or in sandboxes
+     */
+    bool setup() {
+        io_uring_params params{};
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, URING_ENTRIES, &params));
+        if (ring_fd < 0) return false;
+        if (!supports_read_write()) return false;
+        sq_entries = params.sq_entries;
+        cq_entries = params.cq_entries;
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) sq_ring_size = cq_ring_size = max(sq_ring_size, cq_ring_size);
+        sq_ring = map(sq_ring_size, IORING_OFF_SQ_RING);
+        if (!sq_ring) return false;
+        cq_ring = single_mmap ? sq_ring : map(cq_ring_size, IORING_OFF_CQ_RING);
+        if (!cq_ring) return false;
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(map(sqes_size, IORING_OFF_SQES));
+        if (!sqes) return false;
+
+        sq_tail = reinterpret_cast<unsigned *>(static_cast<char *>(sq_ring) + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned *>(static_cast<char *>(sq_ring) + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(static_cast<char *>(sq_ring) + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned *>(static_cast<char *>(cq_ring) + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(static_cast<char *>(cq_ring) + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned *>(static_cast<char *>(cq_ring) + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(cq_ring) + params.cq_off.cqes);
+        return true;
+    }
+
+    void submit(io_request &request) override {
+        // Keep every completion room in the completion queue
+        while (in_flight >= min(sq_entries, cq_entries)) wait_completions();
+
+        const unsigned tail = *sq_tail;
+        const unsigned index = tail & sq_mask;
+        io_uring_sqe &sqe = sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = request.write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe.fd = request.fd;
+        sqe.addr = reinterpret_cast<uint64_t>(request.buffer);
+        sqe.len = static_cast<uint32_t>(request.length);
+        sqe.off = request.offset;
+        sqe.user_data = reinterpret_cast<uint64_t>(&request);
+        sq_array[index] = index;
+        request.done = false;
+        // The kernel reads the entry once it sees the new tail
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        in_flight++;
+
+        if (syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0) < 0) {
+            // Not submitted: run it here so the caller still gets a result
+            __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+            in_flight--;
+            request.result = run_request(request);
+            request.done = true;
+        }
+    }
+
+    void wait(io_request &request) override {
+        while (!request.done) wait_completions();
+    }
+
+    const char *name() const override { return "io_uring"; }
+
+private:
+    /**
+     * Probe the opcodes of the ring, IORING_OP_READ and IORING_OP_WRITE came with Linux 5.6 while the ring itself came
+     * with 5.1
+     * @return false if the kernel cannot run the reads and writes, or is too old to tell
+     */
+    bool supports_read_write() const {
+        vector<char> buffer(sizeof(io_uring_probe) + URING_PROBE_OPS * sizeof(io_uring_probe_op));
+        auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, URING_PROBE_OPS) < 0) return false;
+        const auto supported = [probe](const unsigned op) {
+            return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        };
+        return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+    }
+
+    void *map(const size_t size, const off_t offset) const {
+        void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        return mapped == MAP_FAILED ? nullptr : mapped;
+    }
+
+    /**
+     * Wait for at least one completion and mark all the completed requests done
+     */
+    void wait_completions() {
+        if (reap() > 0) return;
+        syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        reap();
+    }
+
+    size_t reap() {
+        unsigned head = *cq_head;
+        const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        size_t reaped = 0;
+        for (; head != tail; head++, reaped++) {
+            const io_uring_cqe &cqe = cqes[head & cq_mask];
+            auto *request = reinterpret_cast<io_request *>(cqe.user_data);
+            request->result = cqe.res;
+            request->done = true;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        in_flight -= reaped;
+        return reaped;
+    }
+
+    int ring_fd = -1;
+    unsigned sq_entries = 0, cq_entries = 0;
+    size_t in_flight = 0;
+    void *sq_ring = nullptr, *cq_ring = nullptr;
+    size_t sq_ring_size = 0, cq_ring_size = 0, sqes_size = 0;
+    io_uring_sqe *sqes = nullptr;
+    unsigned *sq_tail = nullptr, *sq_array = nullptr, *cq_head = nullptr, *cq_tail = nullptr;
+    unsigned sq_mask = 0, cq_mask = 0;
+    io_uring_cqe *cqes = nullptr;
+};
+
+#endif
+
+unique_ptr<io_backend> io_backend::create(const bool use_uring) {
+#ifdef IO_BACKEND_URING
+    if (use_uring) {
+        auto uring = make_unique<uring_io_backend>();
+        if (uring->setup()) return uring;
+    }
+#endif
+    return make_unique<thread_io_backend>();
+}
@@ -0,0 +1,65 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_IO_BACKEND_H
+#define TEST_IO_BACKEND_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+using namespace std;
+
+/**
+ * One positioned read or write of a file, owned by the caller until it is done
+ */
+struct io_request {
+    int fd = -1;
+    char *buffer = nullptr;
+    size_t length = 0;
+    uint64_t offset = 0;
+    bool write = false;
+    // Set by the backend once the request completes
+    bool done = true;
+    // Bytes transferred, or -errno on failure
+    long result = 0;
+};
+
+/**
+ * Asynchronous file I/O: requests are submitted and run in the background while the caller keeps working, then
+ * waited for one by one.
+ *
+ * On Linux the requests go through an io_uring, so any number of them are in flight with no thread at all. Where
+ * io_uring is not available, a small pool of threads runs them with pread and pwrite. A backend is used by one thread.
+ */
+class io_backend {
+public:
+    virtual ~io_backend() = default;
+
+    /**
+     * Create the best backend available
+     * @param use_uring false to always use the thread pool
+     * @return backend
+     */
+    static unique_ptr<io_backend> create(bool use_uring = true);
+
+    /**
+     * Start a request, which must stay alive and untouched until it is waited for
+     * @param request request to start
+     */
+    virtual void submit(io_request &request) = 0;
+
+    /**
+     * Wait for a submitted request to complete
+     * @param request request to wait for
+     */
+    virtual void wait(io_request &request) = 0;
+
+    /**
+     * Name of the backend: "io_uring" or "threads"
+     */
+    virtual const char *name() const = 0;
+};
+
+#endif //TEST_IO_BACKEND_H
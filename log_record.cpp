@@ -0,0 +1,21 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include "log_record.h"
+#include "string_helper.h"
+
+/**
+ * Parse a log line into record without any allocation
+ * @param line log line in cvs format without the trailing new line
+ * @param record output record with views into line
+ * @return true if line has all the three fields
+ */
+bool log_record::parse(const string_view line, log_record &record) {
+    string_view fields[3];
+    if (string_helper::split(line, ',', fields, 3) != 3) return false;
+    record.timestamp = fields[0];
+    record.page_id = fields[1];
+    record.customer_id = fields[2];
+    return true;
+}
@@ -0,0 +1,35 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_LOG_RECORD_H
+#define TEST_LOG_RECORD_H
+
+#include <cstddef>
+#include <string_view>
+
+using namespace std;
+
+/**
+ * One log record in cvs format: Timestamp, PageId, CustomerId.
+ *
+ * Every field is a view into the buffer the line was read from, so the record is only valid while that buffer is.
+ */
+struct log_record {
+    // Shortest possible log line: timestamp, page id and a 36-char customer id with their delimiters and new line
+    static constexpr size_t MIN_RECORD_SIZE = 40;
+
+    string_view timestamp;
+    string_view page_id;
+    string_view customer_id;
+
+    /**
+     * Parse a log line into record without any allocation
+     * @param line log line in cvs format without the trailing new line
+     * @param record output record with views into line
+     * @return true if line has all the three fields
+     */
+    static bool parse(string_view line, log_record &record);
+};
+
+#endif //TEST_LOG_RECORD_H
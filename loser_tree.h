@@ -0,0 +1,76 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_LOSER_TREE_H
+#define TEST_LOSER_TREE_H
+
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Tournament tree of losers for a K-way merge.
+ *
+ * Every internal node keeps the source that lost the match played there and the overall winner sits on top. After
+ * the winner's source advances to its next record, replay walks only the path from that source's leaf to the root,
+ * so each output record costs about log2(K) comparisons, half of what a binary heap pop and push needs.
+ *
+ * @tparam Less less(a, b) is true when the current record of source a must be output before the one of source b;
+ * it has to rank exhausted sources after all the others
+ */
+template<typename Less>
+class loser_tree {
+public:
+    loser_tree(const size_t sources_count, Less less) : sources_count(sources_count), tree(sources_count),
+                                                         less(std::move(less)) {}
+
+    /**
+     * Play the whole tournament, once every source holds its first record
+     */
+    void build() {
+        if (sources_count == 0) return;
+        vector<size_t> winners(2 * sources_count);
+        for (size_t source = 0; source < sources_count; source++) winners[sources_count + source] = source;
+        for (size_t node = sources_count - 1; node > 0; node--) {
+            const size_t left = winners[2 * node], right = winners[2 * node + 1];
+            const bool right_wins = less(right, left);
+            comparisons++;
+            winners[node] = right_wins ? right : left;
+            tree[node] = right_wins ? left : right;
+        }
+        tree[0] = winners[1];
+    }
+
+    /**
+     * Get the source holding the smallest record
+     * @return source index
+     */
+    size_t winner() const { return tree[0]; }
+
+    /**
+     * Replay the matches of the winner's source after it advanced to its next record or got exhausted
+     */
+    void replay() {
+        size_t winner = tree[0];
+        for (size_t node = (winner + sources_count) / 2; node > 0; node /= 2, comparisons++)
+            if (less(tree[node], winner)) swap(tree[node], winner);
+        tree[0] = winner;
+    }
+
+    /**
+     * Get the number of matches played so far
+     */
+    size_t comparisons_count() const { return comparisons; }
+
+private:
+    const size_t sources_count;
+    // tree[0] is the winner, tree[1..sources_count - 1] the losers, source i is the leaf sources_count + i
+    vector<size_t> tree;
+    Less less;
+    size_t comparisons = 0;
+};
+
+#endif //TEST_LOSER_TREE_H
@@ -0,0 +1,17 @@
+# Compare the loyal customers printed by an engine with the ones of a result file, in any order
+# @param engine engine and arguments, for the error message
+# @param output what the engine printed
+# @param expected_file result file
+function(compare_loyal_customers engine output expected_file)
+    file(READ ${expected_file} expected)
+    set(uuid_regex "[0-9a-f]+-[0-9a-f]+-[0-9a-f]+-[0-9a-f]+-[0-9a-f]+")
+    string(REGEX MATCHALL "${uuid_regex}" output_ids "${output}")
+    string(REGEX MATCHALL "${uuid_regex}" expected_ids "${expected}")
+    list(SORT output_ids)
+    list(SORT expected_ids)
+    if (NOT output_ids STREQUAL expected_ids)
+        list(LENGTH output_ids output_count)
+        list(LENGTH expected_ids expected_count)
+        message(FATAL_ERROR "${engine} found ${output_count} loyal customers, ${expected_count} expected:\n${output}")
+    endif ()
+endfunction()
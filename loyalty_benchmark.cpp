@@ -0,0 +1,177 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "string_helper.h"
+#include "workload_generator.h"
+
+using namespace std;
+
+/**
+ * End to end benchmark of the loyalty engines on synthetic workloads.
+ *
+ * For every size of the sweep, day logs are generated with workload_generator into <work_dir>/logs, then every
+ * engine binary is run from <work_dir>/run so its ../logs finds them, exactly as in production. Every phase reports
+ * its wall time, its throughput in records/s and MB/s of input, and the peak RSS of the engine process.
+ *
+ * Options are key=value: customers, pages, days, skew (customers), page_skew, churn, seed, sizes (records per day,
+ * comma separated), threads (generating the logs, 0 for all), sort_mem (bytes for ExternalSortingCSV) and work_dir.
+ * The logs and run directories must not exist in work_dir yet, they are removed at the end.
+ */
+
+/**
+ * Wall time and peak memory of one phase
+ */
+struct phase_result {
+    double seconds = 0;
+    long peak_rss_kb = 0;
+    bool ok = true;
+};
+
+/**
+ * Run a program in a directory with its output discarded, and measure it
+ * @param program program path
+ * @param arguments arguments after the program name
+ * @param directory working directory of the program
+ * @return wall time, peak RSS and whether it exited with 0
+ */
+phase_result run_program(const string &program, const vector<string> &arguments, const string &directory) {
+    vector<char *> argv;
+    argv.push_back(const_cast<char *>(program.c_str()));
+    for (const auto &argument: arguments) argv.push_back(const_cast<char *>(argument.c_str()));
+    argv.push_back(nullptr);
+
+    phase_result result;
+    const auto start = chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        if (chdir(directory.c_str()) == 0) execv(program.c_str(), argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    rusage usage{};
+    if (pid < 0 || wait4(pid, &status, 0, &usage) < 0) {
+        result.ok = false;
+        return result;
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    // ru_maxrss is in kilobytes on Linux
+    result.peak_rss_kb = usage.ru_maxrss;
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return result;
+}
+
+void print_phase(const string &name, const phase_result &result, const uint64_t records, const uint64_t bytes) {
+    cout << "  " << left << setw(34) << name << right << fixed << setprecision(3) << setw(9) << result.seconds << " s"
+         << setprecision(0) << setw(13) << records / max(result.seconds, 1e-9) << " records/s"
+         << setprecision(1) << setw(9) << bytes / 1048576.0 / max(result.seconds, 1e-9) << " MB/s";
+    if (result.peak_rss_kb > 0) cout << setw(9) << result.peak_rss_kb / 1024.0 << " MB peak RSS";
+    if (!result.ok) cout << "  FAILED";
+    cout << endl;
+}
+
+int main(const int argc, const char *argv[]) {
+    workload_config config;
+    vector<uint64_t> sizes = {100000, 1000000};
+    unsigned threads = 0;
+    long sort_mem = 64 * 1024 * 1024;
+    string work_dir = "loyalty_benchmark";
+    for (int i = 1; i < argc; i++) {
+        const string option = argv[i];
+        const size_t equal = option.find('=');
+        const string key = option.substr(0, equal), value = equal == string::npos ? "" : option.substr(equal + 1);
+        if (key == "customers") config.customers = strtoull(value.c_str(), nullptr, 0);
+        else if (key == "pages") config.pages = strtoull(value.c_str(), nullptr, 0);
+        else if (key == "days") config.days = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 0));
+        else if (key == "skew") config.customer_skew = strtod(value.c_str(), nullptr);
+        else if (key == "page_skew") config.page_skew = strtod(value.c_str(), nullptr);
+        else if (key == "churn") config.churn = strtod(value.c_str(), nullptr);
+        else if (key == "seed") config.seed = strtoull(value.c_str(), nullptr, 0);
+        else if (key == "threads") threads = static_cast<unsigned>(strtoul(value.c_str(), nullptr, 0));
+        else if (key == "sort_mem") sort_mem = strtol(value.c_str(), nullptr, 0);
+        else if (key == "work_dir") work_dir = value;
+        else if (key == "sizes") {
+            sizes.clear();
+            for (const auto &size: string_helper::split(value, ","))
+                sizes.push_back(strtoull(size.c_str(), nullptr, 0));
+        } else {
+            cout << "Options: customers= pages= days= skew= page_skew= churn= seed= sizes=n,n,... threads="
+                 << " sort_mem= work_dir=" << endl << "Exit program!" << endl;
+            return -1;
+        }
+    }
+    // The set and sorted file engines read day1 to day3
+    config.days = max<uint32_t>(config.days, 3);
+
+    // Engines are built next to the benchmark
+    const filesystem::path bin_dir = filesystem::absolute(argv[0]).parent_path();
+    const filesystem::path work_path = filesystem::absolute(work_dir);
+    const filesystem::path logs_dir = work_path / "logs", run_dir = work_path / "run";
+    // Only the directories made here are removed at the end, never files that were already in work_dir
+    if (filesystem::exists(logs_dir) || filesystem::exists(run_dir)) {
+        cout << "Directory '" << work_path.string() << "' already has logs or run in it!" << endl
+             << "Exit program!" << endl;
+        return -1;
+    }
+    const bool work_dir_created = !filesystem::exists(work_path);
+    filesystem::create_directories(logs_dir);
+    filesystem::create_directories(run_dir);
+
+    cout << "Workload: " << config.customers << " customers, " << config.pages << " pages, " << config.days
+         << " days, skew " << config.customer_skew << ", page skew " << config.page_skew << ", churn " << config.churn
+         << ", seed " << config.seed << endl;
+
+    for (const uint64_t records_per_day: sizes) {
+        config.records_per_day = records_per_day;
+        const workload_generator generator(config);
+        cout << "Size " << records_per_day << " records per day" << endl;
+
+        phase_result generate;
+        uint64_t total_bytes = 0, day1_bytes = 0;
+        const auto start = chrono::steady_clock::now();
+        for (uint32_t day = 1; day <= config.days; day++) {
+            const string day_name = (logs_dir / ("day" + to_string(day) + ".log")).string();
+            const long long bytes = generator.write_day(day, day_name, threads);
+            if (bytes < 0) generate.ok = false;
+            else total_bytes += bytes;
+            if (day == 1) day1_bytes = bytes;
+        }
+        generate.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        const uint64_t total_records = records_per_day * config.days, three_days_records = records_per_day * 3;
+        uint64_t three_days_bytes = 0;
+        for (uint32_t day = 1; day <= 3; day++)
+            three_days_bytes += filesystem::file_size(logs_dir / ("day" + to_string(day) + ".log"));
+        print_phase("generate", generate, total_records, total_bytes);
+
+        print_phase("GetLoyalCustomersUsingSet",
+                    run_program((bin_dir / "GetLoyalCustomersUsingSet").string(), {}, run_dir.string()),
+                    three_days_records, three_days_bytes);
+        print_phase("GetLoyalCustomersUsingSortedFile",
+                    run_program((bin_dir / "GetLoyalCustomersUsingSortedFile").string(), {}, run_dir.string()),
+                    three_days_records, three_days_bytes);
+        print_phase("ExternalSortingCSV (day 1)",
+                    run_program((bin_dir / "ExternalSortingCSV").string(),
+                                {(logs_dir / "day1.log").string(), (run_dir / "day1_sorted.csv").string(),
+                                 to_string(sort_mem)}, run_dir.string()),
+                    records_per_day, day1_bytes);
+    }
+
+    filesystem::remove_all(logs_dir);
+    filesystem::remove_all(run_dir);
+    if (work_dir_created) filesystem::remove(work_path);
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "loyalty_checkpoint.h"
+#include "metrics.h"
+
+static const char CHECKPOINT_MAGIC[8] = {'L', 'C', 'H', 'E', 'C', 'K', 'P', '1'};
+
+/**
+ * Fixed size header at the start of a checkpoint
+ */
+struct checkpoint_header {
+    char magic[8];
+    uint32_t last_day;
+    uint32_t pages_count;
+    uint64_t customers_count;
+};
+
+/**
+ * One customer_state as stored in a checkpoint, with no padding bytes left undefined
+ */
+struct checkpoint_record {
+    uuid128 customer_id;
+    uint32_t last_day;
+    uint32_t days_count;
+    page_ordinal first_page;
+    uint32_t two_pages;
+};
+
+/**
+ * Flush a file or a directory to the disk
+ * @param name file or directory name
+ * @return false if it cannot be opened or flushed
+ */
+static bool sync_to_disk(const string &name) {
+    const int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+bool LoyaltyCheckpoint::load(const string &file_name, customer_state_table &customers,
+                             page_dictionary &page_ids_dictionary, uint32_t &last_day) {
+    const metrics::scoped_timer timer("load_checkpoint");
+    ifstream input(file_name, ios::binary);
+    checkpoint_header header{};
+    if (!input.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+        return false;
+
+    // Page ids are saved once each, so every one gets back its own ordinal
+    if (!page_ids_dictionary.read(input, header.pages_count) || page_ids_dictionary.size() != header.pages_count)
+        return false;
+
+    // The records fill the rest of the file, checked before customers_count sizes the table
+    error_code error;
+    const uint64_t file_size = filesystem::file_size(file_name, error);
+    const auto records_offset = static_cast<uint64_t>(input.tellg());
+    if (error || file_size < records_offset ||
+        (file_size - records_offset) % sizeof(checkpoint_record) != 0 ||
+        (file_size - records_offset) / sizeof(checkpoint_record) != header.customers_count)
+        return false;
+
+    customers.reserve(header.customers_count);
+    vector<checkpoint_record> records(64 * 1024);
+    for (uint64_t remaining = header.customers_count; remaining > 0;) {
+        const size_t count = min<uint64_t>(remaining, records.size());
+        if (!input.read(reinterpret_cast<char *>(records.data()),
+                        static_cast<streamsize>(count * sizeof(checkpoint_record))))
+            return false;
+        for (size_t i = 0; i < count; i++) {
+            // save indexes its page ordinals with first_page, a damaged record must not get that far
+            const checkpoint_record &record = records[i];
+            if (record.last_day == 0 || record.last_day > header.last_day || record.days_count == 0 ||
+                record.days_count > record.last_day || record.two_pages > 1 ||
+                (!record.two_pages && record.first_page >= page_ids_dictionary.size()))
+                return false;
+            customer_state &state = customers.find_or_insert(record.customer_id);
+            // Every customer is saved once
+            if (state.last_day != 0) return false;
+            state.last_day = record.last_day;
+            state.days_count = record.days_count;
+            state.first_page = record.first_page;
+            state.two_pages = record.two_pages != 0;
+        }
+        remaining -= count;
+    }
+    last_day = header.last_day;
+    return true;
+}
+
+bool LoyaltyCheckpoint::save(const string &file_name, const customer_state_table &customers,
+                             const page_dictionary &page_ids_dictionary, const uint32_t last_day) {
+    const metrics::scoped_timer timer("save_checkpoint");
+    // Keep only the pages still compared against, renumbered densely in order of first use
+    static const page_ordinal UNUSED = ~page_ordinal(0);
+    vector<page_ordinal> ordinals(page_ids_dictionary.size(), UNUSED);
+    page_dictionary pages;
+    for (const auto &state: customers.slots())
+        if (state.last_day != 0 && !state.two_pages && ordinals[state.first_page] == UNUSED)
+            ordinals[state.first_page] = pages.intern(page_ids_dictionary.page_id(state.first_page));
+
+    const string temp_file_name = file_name + ".tmp";
+    ofstream output(temp_file_name, ios::binary | ios::trunc);
+    if (!output.is_open()) return false;
+
+    checkpoint_header header{};
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.last_day = last_day;
+    header.pages_count = static_cast<uint32_t>(pages.size());
+    header.customers_count = customers.size();
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    pages.write(output);
+
+    vector<checkpoint_record> records;
+    records.reserve(64 * 1024);
+    const auto flush_records = [&output, &records]() {
+        output.write(reinterpret_cast<const char *>(records.data()),
+                     static_cast<streamsize>(records.size() * sizeof(checkpoint_record)));
+        records.clear();
+    };
+    for (const auto &state: customers.slots()) {
+        if (state.last_day == 0) continue;
+        records.push_back({state.customer_id, state.last_day, state.days_count,
+                           state.two_pages ? 0 : ordinals[state.first_page], state.two_pages});
+        if (records.size() == records.capacity()) flush_records();
+    }
+    flush_records();
+
+    output.close();
+    // The new checkpoint must be on the disk before it replaces the old one, or a crash could leave neither
+    if (output.fail() || !sync_to_disk(temp_file_name)) {
+        filesystem::remove(temp_file_name);
+        return false;
+    }
+    error_code error;
+    filesystem::rename(temp_file_name, file_name, error);
+    if (error) return false;
+    // The rename itself is only durable once the directory is flushed
+    const filesystem::path directory = filesystem::path(file_name).parent_path();
+    return sync_to_disk(directory.empty() ? "." : directory.string());
+}
@@ -0,0 +1,51 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_LOYALTY_CHECKPOINT_H
+#define TEST_LOYALTY_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+
+#include "id_helper.h"
+#include "customer_state_table.h"
+
+using namespace std;
+
+/**
+ * Persistent loyalty state of every customer seen so far, so a new day is folded into the history without reading
+ * the older day logs again.
+ *
+ * Each customer_state is stored as a fixed 32 bytes record, and only the pages still needed are kept: the first page
+ * of the customers that have not visited two unique pages yet. Numbers are stored in host byte order.
+ *
+ * Layout: header | page dictionary (uint32 count, then uint16 length + bytes per page) | customer records
+ */
+class LoyaltyCheckpoint {
+public:
+    /**
+     * Load a checkpoint into an empty table and dictionary
+     * @param file_name checkpoint file name
+     * @param customers output loyalty state by customer id
+     * @param page_ids_dictionary output dictionary the first pages of the customers index
+     * @param last_day output last day folded into the checkpoint
+     * @return false if the file cannot be read, is not a checkpoint or holds records that do not fit together
+     */
+    static bool load(const string &file_name, customer_state_table &customers, page_dictionary &page_ids_dictionary,
+                     uint32_t &last_day);
+
+    /**
+     * Save a checkpoint atomically: it is written next to file_name then renamed over it, so a crash leaves either
+     * the old or the new checkpoint, never a partial one
+     * @param file_name checkpoint file name
+     * @param customers loyalty state by customer id
+     * @param page_ids_dictionary dictionary the first pages of the customers index
+     * @param last_day last day folded into the state
+     * @return false if the checkpoint cannot be written
+     */
+    static bool save(const string &file_name, const customer_state_table &customers,
+                     const page_dictionary &page_ids_dictionary, uint32_t last_day);
+};
+
+#endif //TEST_LOYALTY_CHECKPOINT_H
@@ -0,0 +1,89 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <algorithm>
+#include <bitset>
+
+#include "loyalty_window.h"
+
+loyalty_window::loyalty_window(const size_t window_days, const size_t min_days, const size_t min_pages)
+        : window_days(clamp<size_t>(window_days, 1, MAX_WINDOW_DAYS)), min_days(min_days),
+          min_pages(clamp<size_t>(min_pages, 1, MAX_MIN_PAGES)), customers_of_day(this->window_days) {}
+
+void loyalty_window::begin_day() {
+    current_day++;
+    if (current_day > window_days) expire_day(current_day - window_days);
+}
+
+void loyalty_window::expire_day(const uint32_t day) {
+    const uint64_t day_bit = uint64_t(1) << (day % window_days);
+    auto &customers = customers_of_day[day % window_days];
+    for (const uint32_t state_index: customers) {
+        window_state &state = states[state_index];
+        state.days &= ~day_bit;
+        if (state.days == 0) {
+            // None of the customer's days are left in the window
+            state_indexes.erase(state.customer_id);
+            state.pages_count = 0;
+            free_states.push_back(state_index);
+            continue;
+        }
+        // Drop the pages last visited on the expired day or before
+        page_visit *state_pages = &pages[state_index * min_pages];
+        state.pages_count = static_cast<uint32_t>(
+                remove_if(state_pages, state_pages + state.pages_count, [day](const page_visit &each_page) {
+                    return each_page.last_day <= day;
+                }) - state_pages);
+    }
+    customers.clear();
+}
+
+void loyalty_window::visit(const uuid128 &customer_id, const page_ordinal page_id) {
+    const auto [found, inserted] = state_indexes.try_emplace(customer_id, static_cast<uint32_t>(states.size()));
+    if (inserted) {
+        if (free_states.empty()) {
+            states.emplace_back();
+            pages.resize(states.size() * min_pages);
+        } else {
+            found->second = free_states.back();
+            free_states.pop_back();
+        }
+        states[found->second].customer_id = customer_id;
+    }
+    const uint32_t state_index = found->second;
+    window_state &state = states[state_index];
+
+    const uint64_t day_bit = uint64_t(1) << (current_day % window_days);
+    if ((state.days & day_bit) == 0) {
+        state.days |= day_bit;
+        customers_of_day[current_day % window_days].push_back(state_index);
+    }
+
+    page_visit *state_pages = &pages[state_index * min_pages];
+    page_visit *least_recent = state_pages;
+    for (page_visit *each_page = state_pages; each_page != state_pages + state.pages_count; each_page++) {
+        if (each_page->page_id == page_id) {
+            each_page->last_day = current_day;
+            return;
+        }
+        if (each_page->last_day < least_recent->last_day) least_recent = each_page;
+    }
+    // A new page: keep it in place of the least recently visited one once min_pages are kept
+    if (state.pages_count < min_pages) least_recent = &state_pages[state.pages_count++];
+    *least_recent = {page_id, current_day};
+}
+
+bool loyalty_window::is_loyal(const uint32_t state_index) const {
+    // Expired pages are dropped with their day, so all the pages kept are in the window
+    const window_state &state = states[state_index];
+    return state.pages_count >= min_pages && bitset<MAX_WINDOW_DAYS>(state.days).count() >= min_days;
+}
+
+vector<uuid128> loyalty_window::loyal_customers() const {
+    vector<uuid128> loyal_customers;
+    for (const auto &[customer_id, state_index]: state_indexes)
+        if (is_loyal(state_index)) loyal_customers.push_back(customer_id);
+    sort(loyal_customers.begin(), loyal_customers.end());
+    return loyal_customers;
+}
@@ -0,0 +1,95 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_LOYALTY_WINDOW_H
+#define TEST_LOYALTY_WINDOW_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "id_helper.h"
+
+using namespace std;
+
+/**
+ * Loyalty over a rolling window: customers that came on at least min_days of the last window_days days and visited
+ * at least min_pages distinct pages in those days.
+ *
+ * This is the per customer map<int, set<page>> of GetLoyalCustomersUsingSet, bounded: the days a customer came on are
+ * one bit each in a ring of window_days bits, and of its pages only the min_pages most recently visited ones are kept
+ * with the last day they were seen, which is enough to tell whether min_pages of them are still in the window.
+ *
+ * Every day of the ring lists the customers that came on it, so expiring the oldest day only touches those customers,
+ * and a customer whose last day leaves the window is removed.
+ */
+class loyalty_window {
+public:
+    static constexpr size_t MAX_WINDOW_DAYS = 64;
+    static constexpr size_t MAX_MIN_PAGES = 255;
+
+    /**
+     * @param window_days number of days in the window, at most MAX_WINDOW_DAYS
+     * @param min_days min number of days in the window a loyal customer came on
+     * @param min_pages min number of distinct pages a loyal customer visited in the window, at most MAX_MIN_PAGES
+     */
+    loyalty_window(size_t window_days, size_t min_days, size_t min_pages);
+
+    /**
+     * Start the next day, expiring the day that leaves the window. Must be called before the visits of every day
+     */
+    void begin_day();
+
+    /**
+     * Fold one visit of the current day into the state
+     * @param customer_id customer id
+     * @param page_id page visited
+     */
+    void visit(const uuid128 &customer_id, page_ordinal page_id);
+
+    /**
+     * Get the customers meeting the loyalty criteria over the window ending with the current day
+     * @return loyal customer ids in ascending order
+     */
+    vector<uuid128> loyal_customers() const;
+
+    /**
+     * Number of customers that came on at least one day of the window
+     */
+    size_t size() const { return state_indexes.size(); }
+
+private:
+    struct page_visit {
+        page_ordinal page_id;
+        uint32_t last_day;
+    };
+
+    struct window_state {
+        uuid128 customer_id;
+        // Bit (day % window_days) is set when the customer came on that day of the window, 0 marks a free state
+        uint64_t days = 0;
+        // Number of pages used in this state's min_pages entries of pages
+        uint32_t pages_count = 0;
+    };
+
+    void expire_day(uint32_t day);
+
+    bool is_loyal(uint32_t state_index) const;
+
+    const size_t window_days;
+    const size_t min_days;
+    const size_t min_pages;
+    // Current day, counted from 1, 0 before the first day
+    uint32_t current_day = 0;
+
+    vector<window_state> states;
+    // min_pages entries per state, the most recently visited distinct pages
+    vector<page_visit> pages;
+    vector<uint32_t> free_states;
+    unordered_map<uuid128, uint32_t, uuid128_hash> state_indexes;
+    // Customers that came on each day of the ring, by state index
+    vector<vector<uint32_t>> customers_of_day;
+};
+
+#endif //TEST_LOYALTY_WINDOW_H
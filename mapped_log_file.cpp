@@ -0,0 +1,127 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_log_file.h"
+#include "csv_scanner.h"
+#include "metrics.h"
+
+// Bytes of the file scanned at a time by an iterator, a window grows only for a line longer than that
+static const size_t SCAN_WINDOW_SIZE = 64 * 1024;
+
+MappedLogFile::iterator::iterator(const char *position, const char *end) : end(end) {
+    load(position);
+}
+
+MappedLogFile::iterator &MappedLogFile::iterator::operator++() {
+    const char *next = current.data() + current.size();
+    load(next == end ? end : next + 1);
+    return *this;
+}
+
+MappedLogFile::iterator MappedLogFile::iterator::operator++(int) {
+    iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+/**
+ * Scan a window of the file for its new lines and delimiters
+ * @param position start of the window
+ * @param size size of the window, cut at the end of the file
+ */
+void MappedLogFile::iterator::scan_window(const char *position, const size_t size) {
+    window = position;
+    window_size = min<size_t>(size, end - position);
+    if (positions.size() < window_size) positions.resize(window_size);
+    positions_count = csv_scanner::scan(window, window_size, ',', positions.data());
+    next_position = 0;
+}
+
+/**
+ * Load the first non empty line from position, or become the end iterator
+ * @param position start of a line in the mapped file
+ */
+void MappedLogFile::iterator::load(const char *position) {
+    while (position < end) {
+        if (position < window || position >= window + window_size) scan_window(position, SCAN_WINDOW_SIZE);
+        const size_t offset = position - window;
+        while (next_position < positions_count && positions[next_position] < offset) next_position++;
+
+        // Walk to the new line ending the line, keeping its first two delimiters
+        size_t delimiters[2], delimiters_count = 0, line_end = next_position;
+        for (; line_end < positions_count && window[positions[line_end]] != '\n'; line_end++)
+            if (delimiters_count < 2) delimiters[delimiters_count++] = positions[line_end];
+        if (line_end == positions_count && window + window_size != end) {
+            // The line goes past the window: scan again from its start, with a larger window if it is that long
+            scan_window(position, position == window ? window_size * 2 : SCAN_WINDOW_SIZE);
+            continue;
+        }
+        next_position = line_end;
+        const size_t line_end_offset = line_end < positions_count ? positions[line_end] : window_size;
+        if (line_end_offset == offset) {
+            // Empty line
+            position++;
+            continue;
+        }
+
+        current = string_view(position, line_end_offset - offset);
+        record = log_record();
+        if (delimiters_count == 2) {
+            // Same fields as log_record::parse: the customer id keeps the rest of the line
+            record.timestamp = string_view(position, delimiters[0] - offset);
+            record.page_id = string_view(window + delimiters[0] + 1, delimiters[1] - delimiters[0] - 1);
+            record.customer_id = string_view(window + delimiters[1] + 1, line_end_offset - delimiters[1] - 1);
+        }
+        metrics::add(metric::records_parsed);
+        return;
+    }
+    current = string_view(end, 0);
+}
+
+MappedLogFile::MappedLogFile(const string &file_name) {
+    open(file_name);
+}
+
+MappedLogFile::~MappedLogFile() {
+    close();
+}
+
+bool MappedLogFile::open(const string &file_name) {
+    close();
+    const int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) == 0) {
+        length = file_stat.st_size;
+        if (length == 0) {
+            opened = true;
+        } else {
+            void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                // Records are parsed front to back exactly once: read ahead aggressively, drop pages behind
+                madvise(mapped, length, MADV_SEQUENTIAL);
+                madvise(mapped, length, MADV_WILLNEED);
+                content = static_cast<const char *>(mapped);
+                opened = true;
+                metrics::add(metric::bytes_read, length);
+            } else
+                length = 0;
+        }
+    }
+    ::close(fd);
+    return opened;
+}
+
+void MappedLogFile::close() {
+    if (content) munmap(const_cast<char *>(content), length);
+    content = nullptr;
+    length = 0;
+    opened = false;
+}
@@ -0,0 +1,121 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_MAPPED_LOG_FILE_H
+#define TEST_MAPPED_LOG_FILE_H
+
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <vector>
+
+#include "log_record.h"
+
+using namespace std;
+
+/**
+ * Read only, memory mapped view of a day log file in cvs format: Timestamp, PageId, CustomerId.
+ *
+ * The whole file is mapped with a sequential access hint and walked by a forward iterator of log_record, whose fields
+ * are views straight into the mapping, so no line is ever copied. Empty lines are skipped and the last line does not
+ * need a trailing new line. Records are valid until the file is closed.
+ *
+ * The iterator scans the file a window at a time with csv_scanner, and cuts lines and fields at the new lines and
+ * delimiters found instead of searching every line for them again.
+ */
+class MappedLogFile {
+public:
+    class iterator {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = log_record;
+        using difference_type = ptrdiff_t;
+        using pointer = const log_record *;
+        using reference = const log_record &;
+
+        iterator() = default;
+
+        iterator(const char *position, const char *end);
+
+        reference operator*() const { return record; }
+
+        pointer operator->() const { return &record; }
+
+        iterator &operator++();
+
+        iterator operator++(int);
+
+        bool operator==(const iterator &rhs) const { return current.data() == rhs.current.data(); }
+
+        bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+
+        /**
+         * Get the whole current line without the trailing new line
+         * @return view of the current line in the mapped file
+         */
+        string_view line() const { return current; }
+
+    private:
+        void load(const char *position);
+
+        void scan_window(const char *position, size_t size);
+
+        const char *end = nullptr;
+        string_view current;
+        log_record record;
+        // Window of the file scanned, the offsets in it of its new lines and delimiters, and the next one to read
+        const char *window = nullptr;
+        size_t window_size = 0;
+        vector<uint32_t> positions;
+        size_t positions_count = 0;
+        size_t next_position = 0;
+    };
+
+    MappedLogFile() = default;
+
+    /**
+     * Map a log file, check is_open() for the result
+     * @param file_name log file name
+     */
+    explicit MappedLogFile(const string &file_name);
+
+    MappedLogFile(const MappedLogFile &) = delete;
+
+    MappedLogFile &operator=(const MappedLogFile &) = delete;
+
+    ~MappedLogFile();
+
+    /**
+     * Map a log file, any previous mapping is closed first
+     * @param file_name log file name
+     * @return true if the file is mapped (an empty file is mapped with no records)
+     */
+    bool open(const string &file_name);
+
+    /**
+     * Unmap the file, every record read from it becomes invalid
+     */
+    void close();
+
+    bool is_open() const { return opened; }
+
+    /**
+     * Get the whole mapped file
+     * @return view of the mapped file content
+     */
+    string_view data() const { return {content, length}; }
+
+    size_t size() const { return length; }
+
+    iterator begin() const { return {content, content + length}; }
+
+    iterator end() const { return {content + length, content + length}; }
+
+private:
+    const char *content = nullptr;
+    size_t length = 0;
+    bool opened = false;
+};
+
+#endif //TEST_MAPPED_LOG_FILE_H
@@ -0,0 +1,58 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <algorithm>
+#include <queue>
+
+#include "merge_planner.h"
+
+size_t merge_planner::fan_in_for(const uint64_t mem_size, const size_t read_block_size,
+                                 const size_t output_buffer_size) {
+    const uint64_t output_mem = 2 * uint64_t(output_buffer_size);
+    if (mem_size <= output_mem || read_block_size == 0) return 2;
+    const uint64_t fan_in = (mem_size - output_mem) / (2 * uint64_t(read_block_size));
+    return static_cast<size_t>(clamp<uint64_t>(fan_in, 2, MAX_FAN_IN));
+}
+
+merge_plan merge_planner::plan(const vector<uint64_t> &run_sizes, size_t fan_in) {
+    fan_in = max<size_t>(fan_in, 2);
+
+    struct pending_run {
+        uint64_t size;
+        size_t run;
+        size_t passes;
+    };
+    // Smallest run on top, the older one first among equal sizes
+    const auto larger = [](const pending_run &run1, const pending_run &run2) {
+        return run1.size != run2.size ? run1.size > run2.size : run1.run > run2.run;
+    };
+    priority_queue<pending_run, vector<pending_run>, decltype(larger)> runs(larger);
+    for (size_t run = 0; run < run_sizes.size(); run++) runs.push({run_sizes[run], run, 0});
+
+    merge_plan plan;
+    size_t next_run = run_sizes.size();
+    // Every merge turns fan_in runs into one, taking fan_in - 1 away: the first merge takes the rest of the runs
+    // left over, so the last merge ends with exactly one run
+    size_t merge_size = runs.size() <= fan_in ? runs.size() : (runs.size() - 2) % (fan_in - 1) + 2;
+    while (runs.size() > 1) {
+        merge_step step;
+        step.output = next_run++;
+        uint64_t size = 0;
+        size_t passes = 0;
+        for (size_t i = 0; i < merge_size; i++) {
+            const pending_run run = runs.top();
+            runs.pop();
+            step.inputs.push_back(run.run);
+            size += run.size;
+            passes = max(passes, run.passes);
+        }
+        sort(step.inputs.begin(), step.inputs.end());
+        runs.push({size, step.output, passes + 1});
+        plan.bytes_written += size;
+        plan.passes = max(plan.passes, passes + 1);
+        plan.steps.push_back(std::move(step));
+        merge_size = min(fan_in, runs.size());
+    }
+    return plan;
+}
@@ -0,0 +1,65 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_MERGE_PLANNER_H
+#define TEST_MERGE_PLANNER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+/**
+ * One merge of a plan. Runs are numbered from 0: the sorted runs first, then the run made by every merge in order
+ */
+struct merge_step {
+    // Runs merged, in increasing order
+    vector<size_t> inputs;
+    size_t output = 0;
+};
+
+/**
+ * Merges turning the sorted runs into one
+ */
+struct merge_plan {
+    vector<merge_step> steps;
+    // Bytes written by all the merges, the final output included
+    uint64_t bytes_written = 0;
+    // Most merges any row goes through
+    size_t passes = 0;
+};
+
+/**
+ * Plan of the merge phase of an external sort.
+ *
+ * The fan-in is the number of runs the memory budget can read at once, each with two read ahead blocks, next to the
+ * two output buffers. Merges are then scheduled like a Huffman code of that arity: the smallest runs are always
+ * merged first, and the first merge only takes as many runs as needed for every later merge to be full. This writes
+ * the fewest bytes of all the plans, and with runs of about the same size it also takes the fewest passes.
+ */
+class merge_planner {
+public:
+    // Runs merged at once at most, every one of them keeps a file open
+    static constexpr size_t MAX_FAN_IN = 1000;
+
+    /**
+     * Get the fan-in a memory budget allows
+     * @param mem_size memory for the merge in bytes
+     * @param read_block_size read ahead block of every run, two of them per run
+     * @param output_buffer_size output buffer, two of them
+     * @return runs merged at once, from 2 to MAX_FAN_IN
+     */
+    static size_t fan_in_for(uint64_t mem_size, size_t read_block_size, size_t output_buffer_size);
+
+    /**
+     * Plan the merges of sorted runs
+     * @param run_sizes size of every sorted run in bytes
+     * @param fan_in runs merged at once at most, at least 2
+     * @return merges in the order to run them, none for less than two runs
+     */
+    static merge_plan plan(const vector<uint64_t> &run_sizes, size_t fan_in);
+};
+
+#endif //TEST_MERGE_PLANNER_H
@@ -0,0 +1,95 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <sys/resource.h>
+
+#include "metrics.h"
+
+static const size_t METRICS_COUNT = static_cast<size_t>(metric::metrics_count);
+static const char *const METRIC_NAMES[METRICS_COUNT] = {
+        "bytes_read", "bytes_written", "records_parsed", "runs_written", "merge_passes", "heap_comparisons",
+        "hash_probes"};
+
+/**
+ * Total time of a phase
+ */
+struct phase_total {
+    string name;
+    chrono::steady_clock::duration duration{};
+    uint64_t calls = 0;
+};
+
+static string program_name, summary_file_name;
+static chrono::steady_clock::time_point program_start;
+static atomic<uint64_t> totals[METRICS_COUNT];
+static mutex phases_mutex;
+static vector<phase_total> phases;
+
+/**
+ * Counts of one thread, added to the totals when the thread ends
+ */
+struct thread_counts {
+    uint64_t counts[METRICS_COUNT] = {};
+
+    ~thread_counts() {
+        for (size_t i = 0; i < METRICS_COUNT; i++)
+            if (counts[i]) totals[i].fetch_add(counts[i], memory_order_relaxed);
+    }
+};
+
+void metrics::start(const string &program) {
+    const char *file_name = getenv("LOYALTY_METRICS");
+    if (!file_name || !*file_name || is_enabled) return;
+    program_name = program;
+    summary_file_name = file_name;
+    program_start = chrono::steady_clock::now();
+    is_enabled = true;
+    // Thread counts of the main thread are added up before functions registered with atexit run
+    atexit(write_summary);
+}
+
+void metrics::add_enabled(const metric counter, const uint64_t count) {
+    thread_local thread_counts local;
+    local.counts[static_cast<size_t>(counter)] += count;
+}
+
+void metrics::add_phase(const char *phase, const chrono::steady_clock::duration duration) {
+    lock_guard<mutex> lock(phases_mutex);
+    auto found = phases.begin();
+    while (found != phases.end() && found->name != phase) ++found;
+    if (found == phases.end()) found = phases.insert(phases.end(), {phase});
+    found->duration += duration;
+    found->calls++;
+}
+
+void metrics::write_summary() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto seconds = [](const chrono::steady_clock::duration duration) {
+        return chrono::duration<double>(duration).count();
+    };
+
+    ofstream summary_file;
+    if (summary_file_name != "-") summary_file.open(summary_file_name, ios::trunc);
+    ostream &output = summary_file_name != "-" ? summary_file : cerr;
+    output << fixed << setprecision(6) << "{\"program\": \"" << program_name << "\", \"wall_seconds\": "
+           << seconds(chrono::steady_clock::now() - program_start)
+           // ru_maxrss is in kilobytes on Linux
+           << ", \"peak_rss_bytes\": " << static_cast<uint64_t>(usage.ru_maxrss) * 1024 << ", \"counters\": {";
+    for (size_t i = 0; i < METRICS_COUNT; i++)
+        output << (i ? ", \"" : "\"") << METRIC_NAMES[i] << "\": " << totals[i].load(memory_order_relaxed);
+    output << "}, \"phases\": {";
+    lock_guard<mutex> lock(phases_mutex);
+    for (size_t i = 0; i < phases.size(); i++)
+        output << (i ? ", \"" : "\"") << phases[i].name << "\": {\"seconds\": " << seconds(phases[i].duration)
+               << ", \"calls\": " << phases[i].calls << "}";
+    output << "}}" << endl;
+}
@@ -0,0 +1,93 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_METRICS_H
+#define TEST_METRICS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+/**
+ * Counters kept by metrics
+ */
+enum class metric {
+    bytes_read,
+    bytes_written,
+    records_parsed,
+    runs_written,
+    merge_passes,
+    heap_comparisons,
+    hash_probes,
+    metrics_count
+};
+
+/**
+ * Phase timers and counters of a tool, written out as one JSON object when the program exits.
+ *
+ * Metrics are enabled by the LOYALTY_METRICS environment variable, naming the file the summary is written to, or "-"
+ * for the standard error. When disabled, counting and timing cost one test of a flag, so the calls stay in the hot
+ * paths. Counts are batched per thread and added up when the thread ends.
+ *
+ * Summary: {"program", "wall_seconds", "peak_rss_bytes", "counters": {name: count}, "phases": {name: {"seconds",
+ * "calls"}}}, with the phases in the order they first ran.
+ */
+class metrics {
+public:
+    /**
+     * Enable metrics if LOYALTY_METRICS is set, the summary is written at exit
+     * @param program program name in the summary
+     */
+    static void start(const string &program);
+
+    static bool enabled() { return is_enabled; }
+
+    /**
+     * Add to a counter
+     * @param counter counter to add to
+     * @param count count to add
+     */
+    static void add(const metric counter, const uint64_t count = 1) {
+        if (is_enabled) add_enabled(counter, count);
+    }
+
+    /**
+     * Time the scope it lives in as one call of a phase, phases with the same name add up
+     */
+    class scoped_timer {
+    public:
+        /**
+         * @param phase phase name, a string literal
+         */
+        explicit scoped_timer(const char *phase) : phase(is_enabled ? phase : nullptr) {
+            if (this->phase) start_time = chrono::steady_clock::now();
+        }
+
+        scoped_timer(const scoped_timer &) = delete;
+
+        scoped_timer &operator=(const scoped_timer &) = delete;
+
+        ~scoped_timer() {
+            if (phase) add_phase(phase, chrono::steady_clock::now() - start_time);
+        }
+
+    private:
+        const char *phase;
+        chrono::steady_clock::time_point start_time;
+    };
+
+private:
+    static void write_summary();
+
+    static void add_enabled(metric counter, uint64_t count);
+
+    static void add_phase(const char *phase, chrono::steady_clock::duration duration);
+
+    static inline bool is_enabled = false;
+};
+
+#endif //TEST_METRICS_H
@@ -0,0 +1,134 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_RADIX_SORT_H
+#define TEST_RADIX_SORT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Buckets smaller than this are finished with std::sort, below it the counting passes cost more than they save
+static const size_t RADIX_SORT_CUTOFF = 64;
+
+/**
+ * A record being radix sorted, with the 8 key bytes from the current depth cached next to it so the counting passes
+ * stream through a contiguous array instead of chasing every key
+ */
+struct radix_entry {
+    // Key bytes [depth, depth + 8) big endian, zero padded
+    uint64_t prefix;
+    // Number of key bytes in prefix, less than 8 when the key ends in it
+    uint32_t length;
+    uint32_t record;
+};
+
+/**
+ * One stable counting sort pass over entries by one byte digit
+ * @param first first entry
+ * @param last past the last entry
+ * @param buffer scratch space for last - first entries
+ * @param digit digit(entry) returns the byte to sort by
+ */
+template<typename Digit>
+void radix_pass(radix_entry *first, radix_entry *last, radix_entry *buffer, const Digit &digit) {
+    size_t counts[256] = {};
+    for (const radix_entry *entry = first; entry != last; entry++) counts[digit(*entry)]++;
+    // Skip the pass when every entry has the same digit, such as the shared bytes of a customer id
+    if (counts[digit(*first)] == static_cast<size_t>(last - first)) return;
+    size_t next[256];
+    size_t position = 0;
+    for (size_t bucket = 0; bucket < 256; bucket++) {
+        next[bucket] = position;
+        position += counts[bucket];
+    }
+    for (const radix_entry *entry = first; entry != last; entry++) buffer[next[digit(*entry)]++] = *entry;
+    copy(buffer, buffer + (last - first), first);
+}
+
+/**
+ * Sort a bucket of entries sharing their first depth key bytes: radix sort the next 8 key bytes least significant
+ * byte first, then sort every group still sharing all 8 bytes on the following 8, most significant word first
+ * @tparam Key key(i) returns the key of record i as a string_view
+ * @param first first entry of the bucket
+ * @param last past the last entry of the bucket
+ * @param buffer scratch space for last - first entries
+ * @param depth number of leading key bytes all the entries of the bucket share
+ * @param key key accessor
+ */
+template<typename Key>
+void msd_radix_sort(radix_entry *first, radix_entry *last, radix_entry *buffer, const size_t depth, const Key &key) {
+    for (radix_entry *entry = first; entry != last; entry++) {
+        const string_view record_key = key(entry->record);
+        const size_t length = depth < record_key.size() ? min<size_t>(record_key.size() - depth, 8) : 0;
+        entry->prefix = 0;
+        for (size_t i = 0; i < length; i++)
+            entry->prefix |= static_cast<uint64_t>(static_cast<unsigned char>(record_key[depth + i])) << (56 - 8 * i);
+        entry->length = static_cast<uint32_t>(length);
+    }
+
+    if (last - first < static_cast<ptrdiff_t>(RADIX_SORT_CUTOFF)) {
+        sort(first, last, [&key, depth](const radix_entry &entry1, const radix_entry &entry2) {
+            if (entry1.prefix != entry2.prefix) return entry1.prefix < entry2.prefix;
+            if (entry1.length != entry2.length || entry1.length < 8) return entry1.length < entry2.length;
+            return key(entry1.record).substr(depth + 8) < key(entry2.record).substr(depth + 8);
+        });
+        return;
+    }
+
+    // A key ending inside the word sorts before a longer key with the same bytes
+    radix_pass(first, last, buffer, [](const radix_entry &entry) { return entry.length; });
+    for (int shift = 0; shift < 64; shift += 8)
+        radix_pass(first, last, buffer, [shift](const radix_entry &entry) {
+            return static_cast<unsigned char>(entry.prefix >> shift);
+        });
+
+    for (radix_entry *group = first; group != last;) {
+        radix_entry *group_end = group + 1;
+        while (group_end != last && group_end->prefix == group->prefix && group_end->length == group->length)
+            group_end++;
+        if (group->length == 8 && group_end - group > 1)
+            msd_radix_sort(group, group_end, buffer, depth + 8, key);
+        group = group_end;
+    }
+}
+
+/**
+ * Get the order of records sorted by their keys, with an MSD radix sort that hands small buckets to std::sort.
+ *
+ * Keys are compared as unsigned bytes like memcmp, so normalized sort keys and plain text both work.
+ * @tparam Key key(i) returns the key of record i as a string_view
+ * @param records_count number of records
+ * @param key key accessor
+ * @return record indexes in sorted order
+ */
+template<typename Key>
+vector<uint32_t> radix_sort_order(const size_t records_count, const Key &key) {
+    vector<radix_entry> entries(records_count), buffer(records_count);
+    for (size_t i = 0; i < records_count; i++) entries[i].record = static_cast<uint32_t>(i);
+    if (records_count > 1) msd_radix_sort(entries.data(), entries.data() + records_count, buffer.data(), 0, key);
+
+    vector<uint32_t> order(records_count);
+    for (size_t i = 0; i < records_count; i++) order[i] = entries[i].record;
+    return order;
+}
+
+/**
+ * Reorder records by a sorted order
+ * @param records records to reorder
+ * @param order record indexes in sorted order
+ */
+template<typename T>
+void apply_order(vector<T> &records, const vector<uint32_t> &order) {
+    vector<T> sorted;
+    sorted.reserve(records.size());
+    for (const auto index: order) sorted.push_back(std::move(records[index]));
+    records.swap(sorted);
+}
+
+#endif //TEST_RADIX_SORT_H
@@ -0,0 +1,36 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include "record_arena.h"
+#include "radix_sort.h"
+
+// Arenas with fewer records are sorted with std::sort, see the radix sort crossover in Benchmark
+static const size_t RADIX_SORT_MIN_ROWS = 1024;
+
+record_arena::record_arena(const size_t capacity) {
+    slab.reserve(capacity);
+}
+
+void record_arena::append(const string_view row, const string_view key) {
+    records.push_back({slab.size(), static_cast<uint32_t>(key.size()), static_cast<uint32_t>(row.size())});
+    slab.insert(slab.end(), key.begin(), key.end());
+    slab.insert(slab.end(), row.begin(), row.end());
+}
+
+void record_arena::clear() {
+    // Only the sizes are reset, vector<char> and vector<descriptor> have nothing to destroy
+    slab.clear();
+    records.clear();
+}
+
+void record_arena::sort() {
+    if (records.size() < RADIX_SORT_MIN_ROWS) {
+        std::sort(records.begin(), records.end(), [this](const descriptor &record1, const descriptor &record2) {
+            return string_view(slab.data() + record1.offset, record1.key_length) <
+                   string_view(slab.data() + record2.offset, record2.key_length);
+        });
+        return;
+    }
+    apply_order(records, radix_sort_order(records.size(), [this](const uint32_t record) { return key(record); }));
+}
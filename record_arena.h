@@ -0,0 +1,91 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_RECORD_ARENA_H
+#define TEST_RECORD_ARENA_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Cvs rows with their normalized sort keys, stored for one run in a single byte slab.
+ *
+ * Every record is its key bytes followed by its row bytes in the slab, located by a fixed size descriptor. Nothing is
+ * allocated per row or per field, sorting only moves the descriptors, and clearing for the next run keeps the slab.
+ * mem_size() counts the slab and the descriptors, so a memory budget checked against it is the memory really used.
+ */
+class record_arena {
+public:
+    /**
+     * @param capacity bytes reserved for the slab up front, such as the memory budget of a run
+     */
+    explicit record_arena(size_t capacity = 0);
+
+    /**
+     * Reserve slab bytes, so appending up to capacity bytes of records never moves the slab
+     * @param capacity bytes of the slab
+     */
+    void reserve(size_t capacity) { slab.reserve(capacity); }
+
+    /**
+     * Copy a record at the end of the arena
+     * @param row cvs row
+     * @param key normalized sort key of the row
+     */
+    void append(string_view row, string_view key);
+
+    /**
+     * Memory a record takes in an arena
+     * @param row cvs row
+     * @param key normalized sort key of the row
+     * @return bytes of the record and its descriptor
+     */
+    static size_t record_size(string_view row, string_view key) {
+        return row.size() + key.size() + sizeof(descriptor);
+    }
+
+    string_view row(size_t index) const {
+        const descriptor &record = records[index];
+        return {slab.data() + record.offset + record.key_length, record.row_length};
+    }
+
+    string_view key(size_t index) const {
+        const descriptor &record = records[index];
+        return {slab.data() + record.offset, record.key_length};
+    }
+
+    size_t size() const { return records.size(); }
+
+    bool empty() const { return records.empty(); }
+
+    /**
+     * Memory used by the records: slab bytes and descriptors
+     */
+    size_t mem_size() const { return slab.size() + records.size() * sizeof(descriptor); }
+
+    /**
+     * Remove all the records, keeping the memory for the next run
+     */
+    void clear();
+
+    /**
+     * Sort the records by their keys, with an MSD radix sort on the key bytes for large arenas
+     */
+    void sort();
+
+private:
+    struct descriptor {
+        uint64_t offset;
+        uint32_t key_length;
+        uint32_t row_length;
+    };
+
+    vector<char> slab;
+    vector<descriptor> records;
+};
+
+#endif //TEST_RECORD_ARENA_H
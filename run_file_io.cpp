@@ -0,0 +1,202 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "run_file_io.h"
+#include "metrics.h"
+
+read_ahead_file::~read_ahead_file() {
+    close();
+}
+
+bool read_ahead_file::open(io_backend &backend, const string &file_name, const size_t block_size,
+                           const size_t blocks_count) {
+    close();
+    fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    // The kernel read ahead adds to ours on sequential files
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    this->backend = &backend;
+    buffers.assign(max<size_t>(blocks_count, 1), vector<char>(block_size));
+    requests.assign(buffers.size(), io_request());
+    next_offset = 0;
+    current_block = 0;
+    has_current = false;
+    at_end = false;
+    read_failed = false;
+    for (size_t block = 0; block < buffers.size(); block++) submit_read(block);
+    return true;
+}
+
+void read_ahead_file::submit_read(const size_t block) {
+    io_request &request = requests[block];
+    request.fd = fd;
+    request.buffer = buffers[block].data();
+    request.length = buffers[block].size();
+    request.offset = next_offset;
+    request.write = false;
+    next_offset += request.length;
+    backend->submit(request);
+}
+
+string_view read_ahead_file::next_block() {
+    if (fd < 0 || at_end) return {};
+    if (has_current) {
+        // The caller is done with the current block: reuse its buffer for the next read
+        submit_read(current_block);
+        current_block = (current_block + 1) % buffers.size();
+    }
+    io_request &request = requests[current_block];
+    backend->wait(request);
+    has_current = true;
+    // The blocks after this one are read at fixed offsets: a short read is only the end of the file once a read
+    // returns nothing, before that the rest of the block is read synchronously, it only happens on a signal
+    size_t length = request.result > 0 ? static_cast<size_t>(request.result) : 0;
+    while (request.result > 0 && length < request.length) {
+        const ssize_t read = pread(fd, request.buffer + length, request.length - length,
+                                   static_cast<off_t>(request.offset + length));
+        if (read < 0 && errno == EINTR) continue;
+        if (read <= 0) {
+            if (read < 0) request.result = read;
+            break;
+        }
+        length += read;
+    }
+    if (request.result < 0) read_failed = true;
+    if (request.result <= 0) {
+        at_end = true;
+        return {};
+    }
+    metrics::add(metric::bytes_read, length);
+    // The reads after the end of the file return nothing
+    if (length < request.length) at_end = true;
+    return {request.buffer, length};
+}
+
+void read_ahead_file::close() {
+    if (fd < 0) return;
+    // Every read in flight has to complete before its buffer goes away
+    for (auto &request: requests) backend->wait(request);
+    ::close(fd);
+    fd = -1;
+    buffers.clear();
+    requests.clear();
+}
+
+bool run_line_reader::open(io_backend &backend, const string &file_name, const size_t block_size) {
+    block = {};
+    return file.open(backend, file_name, block_size);
+}
+
+bool run_line_reader::next_line(string_view &line) {
+    spanning_line.clear();
+    bool spanning = false;
+    for (;;) {
+        if (block.empty()) {
+            block = file.next_block();
+            if (block.empty()) {
+                // The last line doesn't need a new line
+                line = spanning_line;
+                return spanning;
+            }
+        }
+        const auto *new_line = static_cast<const char *>(memchr(block.data(), '\n', block.size()));
+        if (new_line) {
+            const size_t length = new_line - block.data();
+            if (spanning) {
+                spanning_line.append(block.data(), length);
+                line = spanning_line;
+            } else
+                line = block.substr(0, length);
+            block.remove_prefix(length + 1);
+            return true;
+        }
+        // The line goes on in the next block, which invalidates this one
+        spanning_line.append(block.data(), block.size());
+        spanning = true;
+        block = {};
+    }
+}
+
+write_behind_file::~write_behind_file() {
+    close();
+}
+
+bool write_behind_file::open(io_backend &backend, const string &file_name, const size_t buffer_size,
+                             const size_t buffers_count) {
+    close();
+    fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    // Writes to a file that did not open are dropped, and close reports the failure
+    failed = fd < 0;
+    if (failed) return false;
+    this->backend = &backend;
+    buffers.assign(max<size_t>(buffers_count, 1), vector<char>(max<size_t>(buffer_size, 1)));
+    requests.assign(buffers.size(), io_request());
+    current_buffer = 0;
+    current_size = 0;
+    next_offset = 0;
+    failed = false;
+    return true;
+}
+
+void write_behind_file::write(string_view data) {
+    if (fd < 0) return;
+    while (!data.empty()) {
+        vector<char> &buffer = buffers[current_buffer];
+        const size_t length = min(data.size(), buffer.size() - current_size);
+        memcpy(buffer.data() + current_size, data.data(), length);
+        current_size += length;
+        data.remove_prefix(length);
+        if (current_size == buffer.size()) flush_current();
+    }
+}
+
+void write_behind_file::flush_current() {
+    if (current_size == 0) return;
+    io_request &request = requests[current_buffer];
+    request.fd = fd;
+    request.buffer = buffers[current_buffer].data();
+    request.length = current_size;
+    request.offset = next_offset;
+    request.write = true;
+    next_offset += current_size;
+    backend->submit(request);
+    metrics::add(metric::bytes_written, current_size);
+
+    // Fill the next buffer once its previous write is done
+    current_buffer = (current_buffer + 1) % buffers.size();
+    current_size = 0;
+    wait_write(requests[current_buffer]);
+}
+
+void write_behind_file::wait_write(io_request &request) {
+    backend->wait(request);
+    // Finish a short write synchronously, it only happens on a full disk or a signal
+    while (!failed && request.result >= 0 && static_cast<size_t>(request.result) < request.length) {
+        request.buffer += request.result;
+        request.length -= request.result;
+        request.offset += request.result;
+        const ssize_t written = pwrite(fd, request.buffer, request.length, static_cast<off_t>(request.offset));
+        if (written <= 0) failed = true;
+        else request.result = written;
+    }
+    if (request.result < 0) failed = true;
+    // Waiting again for the same request must not redo the checks
+    request.length = request.result = 0;
+}
+
+bool write_behind_file::close() {
+    if (fd < 0) return !failed;
+    flush_current();
+    for (auto &request: requests) wait_write(request);
+    ::close(fd);
+    fd = -1;
+    buffers.clear();
+    requests.clear();
+    return !failed;
+}
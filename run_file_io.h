@@ -0,0 +1,156 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_RUN_FILE_IO_H
+#define TEST_RUN_FILE_IO_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "io_backend.h"
+
+using namespace std;
+
+/**
+ * Sequential reader of a run file in large blocks: while one block is being parsed, the next ones are already being
+ * read by the io_backend.
+ */
+class read_ahead_file {
+public:
+    read_ahead_file() = default;
+
+    read_ahead_file(const read_ahead_file &) = delete;
+
+    read_ahead_file &operator=(const read_ahead_file &) = delete;
+
+    ~read_ahead_file();
+
+    /**
+     * Open a file and start reading its first blocks
+     * @param backend backend running the reads, must outlive the file
+     * @param file_name file name
+     * @param block_size bytes of every read
+     * @param blocks_count blocks read ahead, 2 for double buffering
+     * @return false if the file cannot be opened
+     */
+    bool open(io_backend &backend, const string &file_name, size_t block_size, size_t blocks_count = 2);
+
+    /**
+     * Get the next block of the file, the previous block returned becomes invalid
+     * @return next block, empty at the end of the file or on a read error
+     */
+    string_view next_block();
+
+    /**
+     * @return true if a read failed, the blocks before it were all returned
+     */
+    bool failed() const { return read_failed; }
+
+    void close();
+
+private:
+    void submit_read(size_t block);
+
+    io_backend *backend = nullptr;
+    int fd = -1;
+    vector<vector<char>> buffers;
+    vector<io_request> requests;
+    // Offset of the next block to read, and the block the caller has now, if any
+    uint64_t next_offset = 0;
+    size_t current_block = 0;
+    bool has_current = false;
+    bool at_end = false;
+    bool read_failed = false;
+};
+
+/**
+ * Line by line reader of a run file on top of read_ahead_file, lines are handed out as views without copies unless
+ * they span two blocks
+ */
+class run_line_reader {
+public:
+    /**
+     * @return false if the file cannot be opened
+     */
+    bool open(io_backend &backend, const string &file_name, size_t block_size);
+
+    /**
+     * Read the next line
+     * @param line output line without its new line, valid until the next call
+     * @return false at the end of the file or on a read error
+     */
+    bool next_line(string_view &line);
+
+    /**
+     * @return true if a read failed before the end of the file
+     */
+    bool failed() const { return file.failed(); }
+
+    void close() { file.close(); }
+
+private:
+    read_ahead_file file;
+    string_view block;
+    // A line spanning blocks is put together here
+    string spanning_line;
+};
+
+/**
+ * Writer of a file through large buffers: a full buffer is written by the io_backend while the next one fills.
+ */
+class write_behind_file {
+public:
+    write_behind_file() = default;
+
+    write_behind_file(const write_behind_file &) = delete;
+
+    write_behind_file &operator=(const write_behind_file &) = delete;
+
+    ~write_behind_file();
+
+    /**
+     * Create or truncate a file
+     * @param backend backend running the writes, must outlive the file
+     * @param file_name file name
+     * @param buffer_size bytes of every write
+     * @param buffers_count buffers in flight plus the one filling, 2 for double buffering
+     * @return false if the file cannot be created
+     */
+    bool open(io_backend &backend, const string &file_name, size_t buffer_size, size_t buffers_count = 2);
+
+    /**
+     * Append data, dropped if the file is not open
+     */
+    void write(string_view data);
+
+    void put(const char c) { write(string_view(&c, 1)); }
+
+    /**
+     * Start writing the buffer filling now, without waiting for it: close waits for it
+     */
+    void flush() { flush_current(); }
+
+    /**
+     * Write what is left and wait for all the writes
+     * @return false if the file did not open or any write failed
+     */
+    bool close();
+
+private:
+    void flush_current();
+
+    void wait_write(io_request &request);
+
+    io_backend *backend = nullptr;
+    int fd = -1;
+    vector<vector<char>> buffers;
+    vector<io_request> requests;
+    size_t current_buffer = 0;
+    size_t current_size = 0;
+    uint64_t next_offset = 0;
+    bool failed = false;
+};
+
+#endif //TEST_RUN_FILE_IO_H
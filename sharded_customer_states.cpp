@@ -0,0 +1,101 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <thread>
+#include <functional>
+#include <numeric>
+
+#include "sharded_customer_states.h"
+#include "mapped_log_file.h"
+#include "metrics.h"
+
+// Bytes of log parsed by each worker in one round, bounds the memory held by the scattered visits
+static const size_t ROUND_SIZE_PER_THREAD = 64 * 1024 * 1024;
+
+/**
+ * Run a task on threads_count threads and wait for all of them
+ * @param threads_count number of threads
+ * @param task task called with the thread index
+ */
+static void run_parallel(const size_t threads_count, const function<void(size_t)> &task) {
+    vector<thread> threads;
+    threads.reserve(threads_count);
+    for (size_t i = 0; i < threads_count; i++) threads.emplace_back(task, i);
+    for (auto &t: threads) t.join();
+}
+
+/**
+ * Get the start of the line after position
+ * @param data log file content
+ * @param position any position in data
+ * @return position right after the next new line from position, or data size
+ */
+static size_t next_line_start(const string_view data, const size_t position) {
+    if (position >= data.size()) return data.size();
+    const size_t new_line = data.find('\n', position);
+    return new_line == string_view::npos ? data.size() : new_line + 1;
+}
+
+sharded_customer_states::sharded_customer_states(const size_t threads_count) : shards(max<size_t>(threads_count, 1)) {}
+
+size_t sharded_customer_states::shard_of(const uuid128 &customer_id) const {
+    // The tables index with the low hash bits, shard with the high ones so every shard still spreads evenly
+    return (uuid128_hash()(customer_id) >> 32) % shards.size();
+}
+
+void sharded_customer_states::add_log_file(const string &file_name, const int day,
+                                           const vector<customer_filter> &customers_by_day) {
+    const metrics::scoped_timer timer("read_day");
+    const MappedLogFile log_file(file_name);
+    const string_view data = log_file.data();
+    const size_t threads_count = shards.size();
+    // visits[worker][shard] scattered by worker, folded by the owner of shard
+    vector<vector<vector<visit>>> visits(threads_count, vector<vector<visit>>(threads_count));
+    // Records skipped for a malformed customer id, by worker
+    vector<size_t> malformed_counts(threads_count, 0);
+
+    for (size_t round_start = 0; round_start < data.size();) {
+        const size_t round_end = next_line_start(data, round_start + ROUND_SIZE_PER_THREAD * threads_count);
+        // Cut the round into one range per worker, each one starting right after a new line
+        const size_t range_size = (round_end - round_start) / threads_count;
+        vector<size_t> range_starts(threads_count + 1, round_end);
+        range_starts[0] = round_start;
+        for (size_t worker = 1; worker < threads_count; worker++)
+            range_starts[worker] = min(round_end, max(range_starts[worker - 1],
+                                                      next_line_start(data, round_start + worker * range_size)));
+
+        run_parallel(threads_count, [&](const size_t worker) {
+            const size_t range_start = range_starts[worker], range_end = range_starts[worker + 1];
+            uuid128 customer_id;
+            const MappedLogFile::iterator end(data.data() + range_end, data.data() + range_end);
+            for (MappedLogFile::iterator record(data.data() + range_start, data.data() + range_end);
+                 record != end; ++record)
+                if (!id_helper::parse_uuid(record->customer_id, customer_id))
+                    malformed_counts[worker]++;
+                else if (customer_filter::may_come_on_another_day(customers_by_day, customer_id, day))
+                    visits[worker][shard_of(customer_id)].push_back({customer_id, record->page_id});
+        });
+
+        run_parallel(threads_count, [&](const size_t owner) {
+            shard &owned = shards[owner];
+            for (auto &worker_visits: visits) {
+                for (const auto &each_visit: worker_visits[owner]) {
+                    customer_state &state = owned.customers.find_or_insert(each_visit.customer_id);
+                    state.visit(day, state.two_pages ? state.first_page : owned.page_ids.intern(each_visit.page_id));
+                }
+                worker_visits[owner].clear();
+            }
+        });
+
+        round_start = round_end;
+    }
+    id_helper::report_malformed_ids(file_name, accumulate(malformed_counts.begin(), malformed_counts.end(), size_t(0)));
+}
+
+void sharded_customer_states::collect_loyal_customers(set<uuid128> &loyal_customers) const {
+    const metrics::scoped_timer timer("collect");
+    for (const auto &each_shard: shards)
+        for (const auto &state: each_shard.customers.slots())
+            if (state.is_loyal()) loyal_customers.insert(state.customer_id);
+}
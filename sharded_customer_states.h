@@ -0,0 +1,66 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_SHARDED_CUSTOMER_STATES_H
+#define TEST_SHARDED_CUSTOMER_STATES_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+
+#include "id_helper.h"
+#include "customer_state_table.h"
+#include "customer_filter.h"
+
+using namespace std;
+
+/**
+ * Loyalty state partitioned by customer id hash into one shard per worker thread.
+ *
+ * A day log is read in rounds. In each round the file is cut into byte ranges aligned on new lines; every worker
+ * parses one range and scatters its visits by customer shard into its own buffers. Then every worker folds the
+ * visits of the shard it owns from all buffers. A customer only ever lives in one shard and a shard is only ever
+ * touched by one thread, so no lock is needed. Each shard interns pages in its own dictionary, since page ordinals are
+ * only compared within a customer.
+ */
+class sharded_customer_states {
+public:
+    /**
+     * @param threads_count number of worker threads and shards
+     */
+    explicit sharded_customer_states(size_t threads_count);
+
+    /**
+     * Fold all the visits of a day log file into the state, using all the worker threads
+     * @param file_name day log file name
+     * @param day day of the log file, from 1
+     * @param customers_by_day filters of the customers of every day, the visits of a customer that surely came on no
+     * other day are skipped before they are scattered. Empty to keep every visit
+     */
+    void add_log_file(const string &file_name, int day, const vector<customer_filter> &customers_by_day = {});
+
+    /**
+     * Merge the loyal customers of all shards
+     * @param loyal_customers output set of loyal customers
+     */
+    void collect_loyal_customers(set<uuid128> &loyal_customers) const;
+
+private:
+    struct shard {
+        customer_state_table customers;
+        page_dictionary page_ids;
+    };
+
+    struct visit {
+        uuid128 customer_id;
+        string_view page_id;
+    };
+
+    size_t shard_of(const uuid128 &customer_id) const;
+
+    vector<shard> shards;
+};
+
+#endif //TEST_SHARDED_CUSTOMER_STATES_H
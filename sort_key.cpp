@@ -0,0 +1,76 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+
+#include "sort_key.h"
+#include "string_helper.h"
+
+sort_key_encoder::sort_key_encoder(vector<sort_column> columns) : columns(std::move(columns)) {}
+
+sort_key_encoder::sort_key_encoder(const vector<int> &sort_array) {
+    for (const auto &index: sort_array) columns.push_back({index, false, false});
+}
+
+sort_key_encoder sort_key_encoder::parse(const string &sort_order) {
+    vector<sort_column> columns;
+    for (const auto &column_text: string_helper::split(sort_order, ",")) {
+        const vector<string> parts = string_helper::split(column_text, ":");
+        sort_column column;
+        column.index = static_cast<int>(strtol(parts[0].c_str(), nullptr, 0));
+        for (size_t i = 1; i < parts.size(); i++) {
+            if (parts[i] == "desc") column.descending = true;
+            else if (parts[i] == "num") column.numeric = true;
+        }
+        columns.push_back(column);
+    }
+    return sort_key_encoder(columns);
+}
+
+void sort_key_encoder::encode(const string_view row, string &key) const {
+    key.clear();
+    string_view value;
+    for (const auto &column: columns) {
+        const bool found = column.index >= 0 && string_helper::get_field(row, ',', column.index, value);
+        encode_column(column, found, found ? value : string_view(), key);
+    }
+}
+
+void sort_key_encoder::encode(const vector<string> &row, string &key) const {
+    key.clear();
+    for (const auto &column: columns) {
+        const bool found = column.index >= 0 && static_cast<size_t>(column.index) < row.size();
+        encode_column(column, found, found ? string_view(row[column.index]) : string_view(), key);
+    }
+}
+
+void sort_key_encoder::encode_column(const sort_column &column, const bool found, const string_view value,
+                                     string &key) {
+    const size_t column_start = key.size();
+    if (column.numeric) {
+        int64_t number = 0;
+        bool is_number = false;
+        if (found) {
+            const auto result = from_chars(value.data(), value.data() + value.size(), number);
+            is_number = result.ec == errc() && result.ptr == value.data() + value.size();
+        }
+        if (is_number) {
+            key.push_back('\x01');
+            // Flip the sign bit so negative numbers sort before positive ones as unsigned bytes
+            const auto bits = static_cast<uint64_t>(number) ^ 0x8000000000000000ULL;
+            for (int shift = 56; shift >= 0; shift -= 8) key.push_back(static_cast<char>(bits >> shift));
+        } else
+            key.push_back('\x00');
+    } else {
+        for (const char c: value) {
+            key.push_back(c);
+            if (c == '\0') key.push_back('\x01');
+        }
+        key.append(2, '\0');
+    }
+    if (column.descending)
+        for (size_t i = column_start; i < key.size(); i++) key[i] = static_cast<char>(~key[i]);
+}
@@ -0,0 +1,101 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_SORT_KEY_H
+#define TEST_SORT_KEY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A cvs row with its normalized sort key, built once when the row is read so that sorting and merging only compare
+ * keys with memcmp
+ */
+struct keyed_row {
+    string key;
+    string row;
+
+    bool operator<(const keyed_row &rhs) const { return key < rhs.key; }
+
+    /**
+     * Memory used by the row for the memory budget
+     * @return bytes of the row and its key
+     */
+    size_t mem_size() const { return (row.size() + key.size()) * sizeof(char) + 1; }
+};
+
+/**
+ * One cvs column of a sort order
+ */
+struct sort_column {
+    // Zero based column index
+    int index = 0;
+    // Sort from largest to smallest
+    bool descending = false;
+    // Compare as a signed 64-bit integer instead of as text, such as Timestamp
+    bool numeric = false;
+};
+
+/**
+ * Encodes the sort columns of a cvs row into one normalized key, so that comparing two keys with memcmp orders the
+ * rows by all the sort columns at once.
+ *
+ * - text column: its bytes with 0x00 escaped as 0x00 0x01, terminated by 0x00 0x00. The encoding is prefix free, so
+ *   shorter values sort first exactly like string comparison.
+ * - numeric column: 0x01 then the big endian value with the sign bit flipped, or a single 0x00 when the column is
+ *   missing or not a number, which sorts it first.
+ * - descending column: every byte of its ascending encoding inverted.
+ *
+ * A missing column is encoded like an empty value.
+ */
+class sort_key_encoder {
+public:
+    explicit sort_key_encoder(vector<sort_column> columns);
+
+    /**
+     * Ascending text sort order on column indexes
+     * @param sort_array sort index for cvs column
+     */
+    explicit sort_key_encoder(const vector<int> &sort_array);
+
+    /**
+     * Parse a sort order such as "2,1" or "0:num:desc,2": column indexes with optional :num and :desc flags
+     * @param sort_order sort order text
+     * @return encoder of the sort order
+     */
+    static sort_key_encoder parse(const string &sort_order);
+
+    /**
+     * Build the normalized key of a row
+     * @param row cvs row
+     * @param key output key, reused between rows to avoid allocations
+     */
+    void encode(string_view row, string &key) const;
+
+    /**
+     * Build the normalized key of a row already split into columns
+     * @param row cvs columns
+     * @param key output key, reused between rows to avoid allocations
+     */
+    void encode(const vector<string> &row, string &key) const;
+
+    const vector<sort_column> &sort_columns() const { return columns; }
+
+private:
+    /**
+     * Append the encoding of one column value to key
+     * @param column sort column
+     * @param found false if the row has no such column
+     * @param value column value
+     * @param key key to append to
+     */
+    static void encode_column(const sort_column &column, bool found, string_view value, string &key);
+
+    vector<sort_column> columns;
+};
+
+#endif //TEST_SORT_KEY_H
@@ -2,6 +2,8 @@
 // Created by Jerry Shao on 2023-12-14.
 //
 
+#include <algorithm>
+
 #include "string_helper.h"
 
 /**
@@ -10,11 +12,11 @@
  * @return a string with sentence_size in length
  */
 string string_helper::generate_random_string(const int sentence_size) {
-    string result;
-    random_device rd;
-    for (int i = 0; i < sentence_size; i++) {
-        result += char('a' + rd() % 26);
-    }
+    // Seeded once per thread, a random_device is far too slow to build on every call
+    thread_local mt19937 generator(random_device{}());
+    uniform_int_distribution<int> letter_distribution(0, 25);
+    string result(max(sentence_size, 0), 'a');
+    for (auto &letter: result) letter = char('a' + letter_distribution(generator));
     return result;
 }
 
@@ -39,6 +41,43 @@ vector<string> string_helper::split(const string &s, const string &delimiter) {
     return res;
 }
 
+/**
+ * Split a string view using a single character delimiter without any allocation
+ * @param s string view to split
+ * @param delimiter delimiter character to split string
+ * @param fields output array of views into s, one per field
+ * @param max_fields capacity of fields, the last field keeps the rest of s
+ * @return number of fields written into fields
+ */
+size_t string_helper::split(string_view s, const char delimiter, string_view *fields, const size_t max_fields) {
+    if (max_fields == 0) return 0;
+    size_t count = 0, pos_end;
+    while (count + 1 < max_fields && (pos_end = s.find(delimiter)) != string_view::npos) {
+        fields[count++] = s.substr(0, pos_end);
+        s.remove_prefix(pos_end + 1);
+    }
+    fields[count++] = s;
+    return count;
+}
+
+/**
+ * Get one field of a delimited string view without any allocation
+ * @param s string view to search
+ * @param delimiter delimiter character between fields
+ * @param index zero based field index
+ * @param field output view into s for the field
+ * @return true if s has a field at index
+ */
+bool string_helper::get_field(string_view s, const char delimiter, size_t index, string_view &field) {
+    size_t pos_end;
+    for (; index > 0; index--) {
+        if ((pos_end = s.find(delimiter)) == string_view::npos) return false;
+        s.remove_prefix(pos_end + 1);
+    }
+    field = s.substr(0, s.find(delimiter));
+    return true;
+}
+
 /**
  * Join a vector of string using delimiter
  * @param v a vector of string
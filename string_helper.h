@@ -6,6 +6,8 @@
 #define TEST_STRING_HELPER_H
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <iostream>
 #include <random>
 #include <sstream>
@@ -29,6 +31,26 @@ public:
      */
     static vector<string> split(const string &s, const string &delimiter);
 
+    /**
+     * Split a string view using a single character delimiter without any allocation
+     * @param s string view to split
+     * @param delimiter delimiter character to split string
+     * @param fields output array of views into s, one per field
+     * @param max_fields capacity of fields, the last field keeps the rest of s
+     * @return number of fields written into fields
+     */
+    static size_t split(string_view s, char delimiter, string_view *fields, size_t max_fields);
+
+    /**
+     * Get one field of a delimited string view without any allocation
+     * @param s string view to search
+     * @param delimiter delimiter character between fields
+     * @param index zero based field index
+     * @param field output view into s for the field
+     * @return true if s has a field at index
+     */
+    static bool get_field(string_view s, char delimiter, size_t index, string_view &field);
+
     /**
      * Join a vector of string using delimiter
      * @param v a vector of string
@@ -0,0 +1,170 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <thread>
+
+#include "workload_generator.h"
+#include "hash_helper.h"
+
+// Longest record: 20 digit timestamp, 16-char page id, 36-char customer id, two delimiters and a new line
+static const size_t MAX_RECORD_SIZE = 20 + 16 + 36 + 3;
+// Records of a chunk share one random stream, a chunk is about 1MB of records
+static const uint64_t CHUNK_RECORDS = 16384;
+// Timestamps of the first day, in milliseconds
+static const uint64_t FIRST_DAY_TIMESTAMP = 1700000000000ULL;
+static const uint64_t DAY_MILLISECONDS = 86400000ULL;
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+/**
+ * Write the hex digits of a value, most significant first
+ * @param value value to write
+ * @param digits number of low digits of value to write
+ * @param out output buffer
+ */
+static void write_hex(const uint64_t value, const int digits, char *out) {
+    for (int i = 0; i < digits; i++) out[i] = HEX_DIGITS[value >> (4 * (digits - 1 - i)) & 0xF];
+}
+
+/**
+ * log1p(x) / x, also accurate near 0
+ */
+static double log1p_over_x(const double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+/**
+ * expm1(x) / x, also accurate near 0
+ */
+static double expm1_over_x(const double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3.0) * (1 + 0.25 * x));
+}
+
+zipf_distribution::zipf_distribution(const uint64_t n, const double exponent) : n(max<uint64_t>(n, 1)),
+                                                                                 exponent(exponent) {
+    if (exponent <= 0) return;
+    h_integral_x1 = h_integral(1.5) - 1;
+    h_integral_n = h_integral(double(this->n) + 0.5);
+    s = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+}
+
+double zipf_distribution::h(const double x) const {
+    return exp(-exponent * log(x));
+}
+
+double zipf_distribution::h_integral(const double x) const {
+    const double log_x = log(x);
+    return expm1_over_x((1 - exponent) * log_x) * log_x;
+}
+
+double zipf_distribution::h_integral_inverse(const double x) const {
+    double t = x * (1 - exponent);
+    if (t < -1) t = -1;
+    return exp(log1p_over_x(t) * x);
+}
+
+uint64_t zipf_distribution::operator()(mt19937_64 &generator) const {
+    if (exponent <= 0) return generator() % n;
+    uniform_real_distribution<double> uniform(0, 1);
+    for (;;) {
+        const double u = h_integral_n + uniform(generator) * (h_integral_x1 - h_integral_n);
+        const double x = h_integral_inverse(u);
+        const auto k = static_cast<uint64_t>(clamp<double>(x + 0.5, 1, double(n)));
+        if (double(k) - x <= s || u >= h_integral(double(k) + 0.5) - h(double(k))) return k - 1;
+    }
+}
+
+workload_generator::workload_generator(const workload_config &config)
+        : workload(config), page_ids(max<uint64_t>(config.pages, 1)),
+          customer_distribution(config.customers, config.customer_skew),
+          page_distribution(page_ids.size(), config.page_skew),
+          returning_customers(static_cast<uint64_t>(double(config.customers) * (1 - clamp(config.churn, 0.0, 1.0)))) {
+    for (uint64_t page = 0; page < page_ids.size(); page++) {
+        page_ids[page].resize(16);
+        write_hex(hash_helper::mix64(page ^ hash_helper::mix64(workload.seed)), 16, page_ids[page].data());
+    }
+}
+
+size_t workload_generator::format_record(const uint64_t timestamp, const uint64_t page, const uint64_t customer,
+                                         char *out) const {
+    char *position = to_chars(out, out + 20, timestamp).ptr;
+    *position++ = ',';
+    position = copy(page_ids[page].begin(), page_ids[page].end(), position);
+    *position++ = ',';
+
+    // UUID v4 layout of a hash of the customer index: version nibble 4, variant bits 10
+    const uint64_t high = (hash_helper::mix64(customer ^ workload.seed) & ~0xF000ULL) | 0x4000ULL;
+    const uint64_t low =
+            (hash_helper::mix64((customer + 0x632BE59BD9B4E019ULL) ^ workload.seed) & ~(3ULL << 62)) | (2ULL << 62);
+    write_hex(high >> 32, 8, position);
+    position[8] = '-';
+    write_hex(high >> 16, 4, position + 9);
+    position[13] = '-';
+    write_hex(high, 4, position + 14);
+    position[18] = '-';
+    write_hex(low >> 48, 4, position + 19);
+    position[23] = '-';
+    write_hex(low, 12, position + 24);
+    position += 36;
+    *position++ = '\n';
+    return position - out;
+}
+
+size_t workload_generator::format_chunk(const uint32_t day, const uint64_t chunk, char *out) const {
+    mt19937_64 generator(hash_helper::mix64(workload.seed ^ hash_helper::mix64(day) ^ hash_helper::mix64(~chunk)));
+    // One time visitors of a day get indexes no other day uses
+    const uint64_t one_time_base = workload.customers + uint64_t(day) * workload.customers;
+    const uint64_t day_start = FIRST_DAY_TIMESTAMP + uint64_t(day - 1) * DAY_MILLISECONDS;
+
+    const uint64_t first = chunk * CHUNK_RECORDS;
+    const uint64_t last = min(first + CHUNK_RECORDS, workload.records_per_day);
+    size_t size = 0;
+    for (uint64_t record = first; record < last; record++) {
+        const uint64_t rank = customer_distribution(generator);
+        const uint64_t customer = rank < returning_customers ? rank : one_time_base + rank;
+        const uint64_t timestamp = day_start + record * DAY_MILLISECONDS / workload.records_per_day;
+        size += format_record(timestamp, page_distribution(generator), customer, out + size);
+    }
+    return size;
+}
+
+long long workload_generator::write_day(const uint32_t day, const string &file_name, unsigned threads) const {
+    ofstream output(file_name, ios::binary | ios::trunc);
+    if (!output.is_open()) return -1;
+
+    const uint64_t chunks_count = (workload.records_per_day + CHUNK_RECORDS - 1) / CHUNK_RECORDS;
+    if (threads == 0) threads = max(thread::hardware_concurrency(), 1u);
+    threads = static_cast<unsigned>(max<uint64_t>(min<uint64_t>(threads, chunks_count), 1));
+
+    // Two rounds of buffers: one is formatted by the threads while the other is written out
+    vector<string> buffers[2];
+    vector<size_t> sizes[2];
+    for (int i = 0; i < 2; i++) {
+        buffers[i].assign(threads, string(CHUNK_RECORDS * MAX_RECORD_SIZE, '\0'));
+        sizes[i].assign(threads, 0);
+    }
+
+    long long bytes_written = 0;
+    int round = 0;
+    // One more round than needed to write out the last chunks
+    for (uint64_t first_chunk = 0; first_chunk < chunks_count + threads; first_chunk += threads, round ^= 1) {
+        vector<thread> workers;
+        for (unsigned i = 0; i < threads && first_chunk + i < chunks_count; i++)
+            workers.emplace_back([this, day, i, round, first_chunk, &buffers, &sizes]() {
+                sizes[round][i] = format_chunk(day, first_chunk + i, buffers[round][i].data());
+            });
+        // Write the chunks of the previous round meanwhile, in order
+        if (first_chunk > 0)
+            for (unsigned i = 0; i < threads && first_chunk - threads + i < chunks_count; i++) {
+                output.write(buffers[round ^ 1][i].data(), static_cast<streamsize>(sizes[round ^ 1][i]));
+                bytes_written += static_cast<long long>(sizes[round ^ 1][i]);
+            }
+        for (auto &worker: workers) worker.join();
+    }
+    output.close();
+    return output.fail() ? -1 : bytes_written;
+}
@@ -0,0 +1,111 @@
+//
+// Created by Jerry Shao on 2026-10-16.
+//
+
+#ifndef TEST_WORKLOAD_GENERATOR_H
+#define TEST_WORKLOAD_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <random>
+
+using namespace std;
+
+/**
+ * Shape of a synthetic workload of day logs
+ */
+struct workload_config {
+    // Customers that may come on a day
+    uint64_t customers = 100000;
+    uint64_t pages = 2000;
+    uint32_t days = 3;
+    uint64_t records_per_day = 1000000;
+    // Zipf exponents of customer and page popularity, 0 for uniform
+    double customer_skew = 1.0;
+    double page_skew = 1.0;
+    // Share of a day's customers that only come on that day, from 0 to 1
+    double churn = 0.5;
+    uint64_t seed = 42;
+};
+
+/**
+ * Zipf distribution over [0, n): value k is drawn with a probability proportional to 1 / (k + 1)^exponent.
+ *
+ * Sampled in constant time and memory with rejection inversion (Hörmann and Derflinger), so n can be as large as the
+ * customer population.
+ */
+class zipf_distribution {
+public:
+    zipf_distribution(uint64_t n, double exponent);
+
+    uint64_t operator()(mt19937_64 &generator) const;
+
+private:
+    double h(double x) const;
+
+    double h_integral(double x) const;
+
+    double h_integral_inverse(double x) const;
+
+    uint64_t n;
+    double exponent;
+    double h_integral_x1 = 0, h_integral_n = 0, s = 0;
+};
+
+/**
+ * Seeded generator of day logs in cvs format: Timestamp, PageId, CustomerId.
+ *
+ * The same seed always gives the same files. A day's customers are drawn by popularity from a population whose most
+ * popular part comes back every day, while the churn share of it is made of one time visitors of that day only.
+ * Records are formatted straight into large buffers, with timestamps in increasing order through the day.
+ *
+ * A day is cut into fixed chunks of records, each drawn from its own random stream seeded from the seed, the day and
+ * the chunk index. Chunks are formatted by several threads while the previous ones are written out, and the file is
+ * the same whatever the number of threads.
+ */
+class workload_generator {
+public:
+    explicit workload_generator(const workload_config &config);
+
+    /**
+     * Write the log of one day
+     * @param day day from 1 to config.days
+     * @param file_name day log file name, replaced
+     * @param threads threads formatting records, 0 for one per hardware thread
+     * @return bytes written, or -1 if the file cannot be written
+     */
+    long long write_day(uint32_t day, const string &file_name, unsigned threads = 0) const;
+
+    const workload_config &config() const { return workload; }
+
+private:
+    /**
+     * Format one chunk of records of a day
+     * @param day day from 1 to config.days
+     * @param chunk chunk index in the day
+     * @param out output buffer, at least CHUNK_RECORDS * MAX_RECORD_SIZE bytes
+     * @return bytes written
+     */
+    size_t format_chunk(uint32_t day, uint64_t chunk, char *out) const;
+
+    /**
+     * Format one record with its new line
+     * @param timestamp timestamp in milliseconds
+     * @param page page index
+     * @param customer customer index, unique over all the days
+     * @param out output buffer, at least MAX_RECORD_SIZE bytes
+     * @return bytes written
+     */
+    size_t format_record(uint64_t timestamp, uint64_t page, uint64_t customer, char *out) const;
+
+    workload_config workload;
+    // 16-char page ids, formatted once
+    vector<string> page_ids;
+    zipf_distribution customer_distribution;
+    zipf_distribution page_distribution;
+    // Customers that come back every day are the ones ranked below this
+    uint64_t returning_customers;
+};
+
+#endif //TEST_WORKLOAD_GENERATOR_H